@@ -0,0 +1,855 @@
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/pbutils/pbutils.h>
+#include <sps/sps.h>
+#include <detectionmeta.h>
+#include "../src/pipeline.h"
+#include "../src/pipelinestats.h"
+#include "../src/sourcedata.h"
+
+#define DEFAULT_JOB_COUNT 2
+#define DEFAULT_SEGMENT_COUNT 1
+#define PROGRESS_INTERVAL 10 // Seconds between two progress reports
+#define DISCOVER_TIMEOUT 10  // Seconds to wait for the duration of an input
+
+// Values of the objdetection schedule-mode property
+#define DETECTION_SCHEDULE_MODE_RECORD 1
+#define DETECTION_SCHEDULE_MODE_REPLAY 2
+
+typedef struct _ProcessJob ProcessJob;
+typedef struct _ProcessSegment ProcessSegment;
+
+typedef enum _ProcessSegmentType ProcessSegmentType;
+enum _ProcessSegmentType
+{
+    PROCESS_SEGMENT_TYPE_PROCESS, // Decode, process and encode
+    PROCESS_SEGMENT_TYPE_COPY,    // Copy the encoded input
+    PROCESS_SEGMENT_TYPE_ANALYZE, // Find the keyframes and frames with detections, record the detection schedule
+    PROCESS_SEGMENT_TYPE_CONCAT,  // Join the intermediate files of all other segments
+};
+
+// A single input file, processed in one or several segments
+struct _ProcessJob
+{
+    gchar *inputPath, *outputPath;
+    PipelineFileFormat format;
+    GstClockTime duration;
+    gboolean passthrough;
+
+    GPtrArray *segments;
+    guint remainingSegments, outputSegments;
+    PipelineStats *stats; // Combined stats of all finished segments
+
+    GArray *keyframes, *detectionFrames; // Timestamps collected by the analysis
+    GArray *recentFrames;                // Timestamps of the last frames seen by the analysis
+    gboolean lastDetected;
+    GHashTable *schedules; // Detection schedule of every detector, by prefix
+
+    gint64 startTime;
+    gboolean failed;
+};
+
+// A time range of an input file, processed by its own pipeline
+struct _ProcessSegment
+{
+    ProcessJob *job;
+    ProcessSegmentType type;
+    gchar *outputPath;
+    GstClockTime start, stop; // GST_CLOCK_TIME_NONE for the whole file
+
+    SpsSourceData *sourceData;
+    GstElement *pipeline;
+    PipelineStats *stats;
+};
+
+typedef struct _ProcessScheduler ProcessScheduler;
+struct _ProcessScheduler
+{
+    GMainLoop *loop;
+
+    GQueue *pendingSegments;
+    GList *runningSegments;
+    guint maxRunningSegments;
+    guint remainingJobs;
+
+    PipelineFileProfile profile;
+    const gchar *outputDir;
+    guint segmentCount;
+    gboolean passthrough;
+    guint detectionInterval;
+
+    guint64 totalFrames;
+    guint failedJobs;
+};
+
+static ProcessScheduler scheduler;
+
+static gchar *create_output_path(const gchar *inputPath)
+{
+    gchar *dirName = scheduler.outputDir ? g_strdup(scheduler.outputDir) : g_path_get_dirname(inputPath);
+    gchar *fileName = g_path_get_basename(inputPath);
+
+    // Replace extension
+    gchar *dot = strrchr(fileName, '.');
+    if (dot)
+        *dot = 0;
+
+    gchar *outFileName = g_strdup_printf("%s.redacted.%s", fileName, pipeline_file_format_get_extension(scheduler.profile.format));
+    gchar *outPath = g_build_filename(dirName, outFileName, NULL);
+
+    g_free(dirName);
+    g_free(fileName);
+    g_free(outFileName);
+
+    return outPath;
+}
+
+// Get the duration and video codec of an input file, duration is GST_CLOCK_TIME_NONE if unknown
+static GstClockTime discover_input(const gchar *inputPath, gboolean *isH264)
+{
+    GstClockTime duration = GST_CLOCK_TIME_NONE;
+    *isH264 = FALSE;
+
+    GstDiscoverer *discoverer = gst_discoverer_new(DISCOVER_TIMEOUT * GST_SECOND, NULL);
+    gchar *uri = gst_filename_to_uri(inputPath, NULL);
+    if (!discoverer || !uri)
+        goto out;
+
+    GstDiscovererInfo *info = gst_discoverer_discover_uri(discoverer, uri, NULL);
+    if (info)
+    {
+        if (gst_discoverer_info_get_result(info) == GST_DISCOVERER_OK)
+        {
+            duration = gst_discoverer_info_get_duration(info);
+
+            GList *videoStreams = gst_discoverer_info_get_video_streams(info);
+            if (videoStreams)
+            {
+                GstCaps *caps = gst_discoverer_stream_info_get_caps(videoStreams->data);
+                *isH264 = caps && gst_structure_has_name(gst_caps_get_structure(caps, 0), "video/x-h264");
+                if (caps)
+                    gst_caps_unref(caps);
+            }
+            gst_discoverer_stream_info_list_free(videoStreams);
+        }
+        gst_discoverer_info_unref(info);
+    }
+
+out:
+    if (discoverer)
+        g_object_unref(discoverer);
+    g_free(uri);
+
+    return duration;
+}
+
+static ProcessSegment *process_segment_new(ProcessJob *job, ProcessSegmentType type, GstClockTime start, GstClockTime stop)
+{
+    ProcessSegment *segment = g_new0(ProcessSegment, 1);
+    segment->job = job;
+    segment->type = type;
+    segment->start = start;
+    segment->stop = stop;
+
+    g_ptr_array_add(job->segments, segment);
+
+    return segment;
+}
+
+// Create a segment that writes to an intermediate file
+static ProcessSegment *process_segment_new_part(ProcessJob *job, ProcessSegmentType type, GstClockTime start, GstClockTime stop)
+{
+    ProcessSegment *segment = process_segment_new(job, type, start, stop);
+    segment->outputPath = g_strdup_printf("%s.part%02u", job->outputPath, job->segments->len - 1);
+
+    return segment;
+}
+
+// Split into segments of equal duration, without duration the file is processed as a whole
+static GQueue *process_job_split(ProcessJob *job)
+{
+    GQueue *segments = g_queue_new();
+
+    guint segmentCount = GST_CLOCK_TIME_IS_VALID(job->duration) ? scheduler.segmentCount : 1;
+    for (guint i = 0; i < segmentCount; i++)
+    {
+        GstClockTime start = segmentCount == 1 ? GST_CLOCK_TIME_NONE : gst_util_uint64_scale(job->duration, i, segmentCount);
+        GstClockTime stop = i == segmentCount - 1 ? GST_CLOCK_TIME_NONE : gst_util_uint64_scale(job->duration, i + 1, segmentCount);
+        g_queue_push_tail(segments, process_segment_new_part(job, PROCESS_SEGMENT_TYPE_PROCESS, start, stop));
+    }
+
+    return segments;
+}
+
+// Queue the segments producing the output, either behind all others or as the next ones
+static void process_job_schedule(ProcessJob *job, GQueue *segments, gboolean next)
+{
+    // A single segment writes the output directly
+    if (g_queue_get_length(segments) == 1)
+    {
+        ProcessSegment *segment = g_queue_peek_head(segments);
+        g_free(segment->outputPath);
+        segment->outputPath = g_strdup(job->outputPath);
+    }
+
+    job->outputSegments = g_queue_get_length(segments);
+    job->remainingSegments += g_queue_get_length(segments);
+
+    if (next)
+    {
+        for (GList *it = g_queue_peek_tail_link(segments); it != NULL; it = it->prev)
+            g_queue_push_head(scheduler.pendingSegments, it->data);
+    }
+    else
+    {
+        for (GList *it = g_queue_peek_head_link(segments); it != NULL; it = it->next)
+            g_queue_push_tail(scheduler.pendingSegments, it->data);
+    }
+
+    g_queue_free(segments);
+}
+
+static ProcessJob *process_job_new(const gchar *inputPath)
+{
+    ProcessJob *job = g_new0(ProcessJob, 1);
+    job->inputPath = g_strdup(inputPath);
+    job->outputPath = create_output_path(inputPath);
+    job->format = scheduler.profile.format;
+    job->duration = GST_CLOCK_TIME_NONE;
+    job->segments = g_ptr_array_new();
+    job->stats = pipeline_stats_new();
+    job->keyframes = g_array_new(FALSE, FALSE, sizeof(GstClockTime));
+    job->detectionFrames = g_array_new(FALSE, FALSE, sizeof(GstClockTime));
+    job->recentFrames = g_array_new(FALSE, FALSE, sizeof(GstClockTime));
+    job->schedules = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+
+    gboolean isH264 = FALSE;
+    if (scheduler.segmentCount > 1 || scheduler.passthrough)
+        job->duration = discover_input(inputPath, &isH264);
+
+    // Passthrough copies the encoded input, so it has to match the output codec
+    job->passthrough = scheduler.passthrough && isH264;
+    if (scheduler.passthrough && !isH264)
+        g_print("%s: input is not H.264, processing the whole file\n", inputPath);
+
+    // Segments are planned once the analysis is done
+    if (job->passthrough || scheduler.detectionInterval > 1)
+    {
+        g_queue_push_tail(scheduler.pendingSegments, process_segment_new(job, PROCESS_SEGMENT_TYPE_ANALYZE, GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE));
+        job->remainingSegments = 1;
+        return job;
+    }
+
+    process_job_schedule(job, process_job_split(job), FALSE);
+
+    return job;
+}
+
+static void process_job_free(ProcessJob *job)
+{
+    for (guint i = 0; i < job->segments->len; i++)
+    {
+        ProcessSegment *segment = g_ptr_array_index(job->segments, i);
+        g_free(segment->outputPath);
+        g_free(segment);
+    }
+    g_ptr_array_free(job->segments, TRUE);
+
+    g_array_free(job->keyframes, TRUE);
+    g_array_free(job->detectionFrames, TRUE);
+    g_array_free(job->recentFrames, TRUE);
+    g_hash_table_unref(job->schedules);
+    pipeline_stats_free(job->stats);
+    g_free(job->inputPath);
+    g_free(job->outputPath);
+    g_free(job);
+}
+
+static void process_job_report(ProcessJob *job)
+{
+    gdouble seconds = (g_get_monotonic_time() - job->startTime) / (gdouble)G_USEC_PER_SEC;
+    guint64 frames = pipeline_stats_get_frames(job->stats);
+
+    g_print("%s: %" G_GUINT64_FORMAT " frames in %.1f s (%.1f fps)", job->inputPath, frames, seconds, seconds > 0 ? frames / seconds : 0);
+    for (gint stage = 0; stage < PIPELINE_STAGE_COUNT; stage++)
+        g_print(", %s %.2f ms", pipeline_stage_get_name(stage), pipeline_stats_get_stage_average(job->stats, stage));
+    g_print("\n");
+}
+
+static gint compare_clock_time(gconstpointer a, gconstpointer b)
+{
+    GstClockTime timeA = *(const GstClockTime *)a, timeB = *(const GstClockTime *)b;
+    return timeA < timeB ? -1 : timeA > timeB;
+}
+
+// Plan the passthrough: every GOP with a detection is processed, all others are copied
+static GQueue *process_job_plan_passthrough(ProcessJob *job)
+{
+    GArray *keyframes = job->keyframes;
+    guint detection = 0, rangeStart = 0;
+
+    // Decoder did not mark keyframes, so we can not cut the stream
+    if (keyframes->len == 0)
+        return process_job_split(job);
+
+    g_array_sort(job->detectionFrames, compare_clock_time);
+
+    GQueue *segments = g_queue_new();
+    gboolean rangeTouched = FALSE;
+    for (guint gop = 0; gop < keyframes->len; gop++)
+    {
+        GstClockTime gopStop = gop + 1 < keyframes->len ? g_array_index(keyframes, GstClockTime, gop + 1) : GST_CLOCK_TIME_NONE;
+
+        gboolean touched = FALSE;
+        while (detection < job->detectionFrames->len && (!GST_CLOCK_TIME_IS_VALID(gopStop) || g_array_index(job->detectionFrames, GstClockTime, detection) < gopStop))
+        {
+            touched = TRUE;
+            detection++;
+        }
+
+        if (gop == 0)
+            rangeTouched = touched;
+
+        // Close the current range once the type changes
+        if (touched != rangeTouched)
+        {
+            ProcessSegmentType type = rangeTouched ? PROCESS_SEGMENT_TYPE_PROCESS : PROCESS_SEGMENT_TYPE_COPY;
+            g_queue_push_tail(segments, process_segment_new_part(job, type, g_array_index(keyframes, GstClockTime, rangeStart), g_array_index(keyframes, GstClockTime, gop)));
+            rangeStart = gop;
+            rangeTouched = touched;
+        }
+    }
+    ProcessSegmentType type = rangeTouched ? PROCESS_SEGMENT_TYPE_PROCESS : PROCESS_SEGMENT_TYPE_COPY;
+    g_queue_push_tail(segments, process_segment_new_part(job, type, g_array_index(keyframes, GstClockTime, rangeStart), GST_CLOCK_TIME_NONE));
+
+    guint copied = 0;
+    for (GList *it = g_queue_peek_head_link(segments); it != NULL; it = it->next)
+        copied += ((ProcessSegment *)it->data)->type == PROCESS_SEGMENT_TYPE_COPY;
+    g_print("%s: %u GOPs, copying %u of %u ranges\n", job->inputPath, keyframes->len, copied, g_queue_get_length(segments));
+
+    return segments;
+}
+
+static void process_job_finish(ProcessJob *job)
+{
+    // Keep the intermediate files of a failed job, so that the processed parts are not lost
+    for (guint i = 0; i < job->segments->len && job->outputSegments > 1; i++)
+    {
+        ProcessSegment *segment = g_ptr_array_index(job->segments, i);
+        if (segment->type != PROCESS_SEGMENT_TYPE_PROCESS && segment->type != PROCESS_SEGMENT_TYPE_COPY)
+            continue;
+
+        if (!job->failed)
+            g_remove(segment->outputPath);
+        else if (g_file_test(segment->outputPath, G_FILE_TEST_EXISTS))
+            g_printerr("%s: keeping segment %s\n", job->inputPath, segment->outputPath);
+    }
+
+    if (job->failed)
+        scheduler.failedJobs++;
+    else
+        process_job_report(job);
+
+    scheduler.totalFrames += pipeline_stats_get_frames(job->stats);
+    scheduler.remainingJobs--;
+    process_job_free(job);
+}
+
+static gchar *get_detector_key(GstElement *detector)
+{
+    gchar *prefix;
+    g_object_get(detector, "prefix", &prefix, NULL);
+
+    return prefix ? prefix : g_strdup(GST_OBJECT_NAME(detector));
+}
+
+// Sparse inference, recording the detections of the inferred frames
+static void cb_detector_record(const GValue *item, ProcessJob *job)
+{
+    GstElement *detector = g_value_get_object(item);
+    g_object_set(detector, "inference-interval", scheduler.detectionInterval, "schedule-mode", DETECTION_SCHEDULE_MODE_RECORD, NULL);
+}
+
+static void cb_detector_collect(const GValue *item, ProcessJob *job)
+{
+    GstElement *detector = g_value_get_object(item);
+
+    GObject *schedule;
+    g_object_get(detector, "schedule", &schedule, NULL);
+    if (schedule)
+        g_hash_table_replace(job->schedules, get_detector_key(detector), schedule);
+}
+
+// Replay the recorded detections, inferring only where they can not be interpolated
+static void cb_detector_replay(const GValue *item, ProcessJob *job)
+{
+    GstElement *detector = g_value_get_object(item);
+
+    gchar *key = get_detector_key(detector);
+    GObject *schedule = g_hash_table_lookup(job->schedules, key);
+    if (schedule)
+        g_object_set(detector, "schedule", schedule, "schedule-mode", DETECTION_SCHEDULE_MODE_REPLAY, NULL);
+    g_free(key);
+}
+
+static void foreach_detector(GstElement *pipeline, GstIteratorForeachFunction func, ProcessJob *job)
+{
+    GstIterator *it = gst_bin_iterate_all_by_element_factory_name(GST_BIN(pipeline), "objdetection");
+    gst_iterator_foreach(it, func, job);
+    gst_iterator_free(it);
+}
+
+static void process_segment_stop(ProcessSegment *segment)
+{
+    if (segment->pipeline)
+    {
+        // Stop listening before the segment is gone
+        GstBus *bus = gst_element_get_bus(segment->pipeline);
+        gst_bus_remove_watch(bus);
+        gst_object_unref(bus);
+
+        gst_element_set_state(segment->pipeline, GST_STATE_NULL);
+        gst_object_unref(segment->pipeline);
+        segment->pipeline = NULL;
+    }
+    if (segment->stats)
+    {
+        pipeline_stats_accumulate(segment->job->stats, segment->stats);
+        pipeline_stats_free(segment->stats);
+        segment->stats = NULL;
+    }
+    if (segment->sourceData)
+    {
+        g_object_unref(segment->sourceData);
+        segment->sourceData = NULL;
+    }
+}
+
+static void scheduler_run_next();
+
+static void process_segment_finish(ProcessSegment *segment, gboolean failed)
+{
+    ProcessJob *job = segment->job;
+
+    // Keep the recorded detections for the segments producing the output
+    if (!failed && segment->type == PROCESS_SEGMENT_TYPE_ANALYZE)
+        foreach_detector(segment->pipeline, (GstIteratorForeachFunction)cb_detector_collect, job);
+
+    process_segment_stop(segment);
+    scheduler.runningSegments = g_list_remove(scheduler.runningSegments, segment);
+
+    job->failed |= failed;
+    if (!job->failed && segment->type == PROCESS_SEGMENT_TYPE_ANALYZE)
+        process_job_schedule(job, job->passthrough ? process_job_plan_passthrough(job) : process_job_split(job), TRUE);
+    if (--job->remainingSegments == 0)
+    {
+        // The segments are joined by a pipeline of its own, so that the other jobs keep running meanwhile
+        if (!job->failed && job->outputSegments > 1 && segment->type != PROCESS_SEGMENT_TYPE_CONCAT)
+        {
+            ProcessSegment *concat = process_segment_new(job, PROCESS_SEGMENT_TYPE_CONCAT, GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE);
+            concat->outputPath = g_strdup(job->outputPath);
+            g_queue_push_head(scheduler.pendingSegments, concat);
+            job->remainingSegments = 1;
+        }
+        else
+            process_job_finish(job);
+    }
+
+    scheduler_run_next();
+}
+
+static gboolean cb_bus_message(GstBus *bus, GstMessage *msg, ProcessSegment *segment)
+{
+    switch (GST_MESSAGE_TYPE(msg))
+    {
+    case GST_MESSAGE_EOS:
+        process_segment_finish(segment, FALSE);
+        return G_SOURCE_REMOVE;
+    case GST_MESSAGE_ERROR:
+    {
+        GError *error;
+        gchar *debug;
+        gst_message_parse_error(msg, &error, &debug);
+        g_printerr("%s: %s\n", segment->job->inputPath, error->message);
+        GST_DEBUG("%s", debug);
+        g_error_free(error);
+        g_free(debug);
+
+        process_segment_finish(segment, TRUE);
+        return G_SOURCE_REMOVE;
+    }
+    default:
+        return G_SOURCE_CONTINUE;
+    }
+}
+
+// Collect the timestamps of the keyframes the input is cut at
+static GstPadProbeReturn cb_analyze_keyframe(GstPad *pad, GstPadProbeInfo *info, ProcessJob *job)
+{
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT) && GST_BUFFER_PTS_IS_VALID(buffer))
+        g_array_append_val(job->keyframes, GST_BUFFER_PTS(buffer));
+
+    return GST_PAD_PROBE_OK;
+}
+
+// Collect the timestamps of the frames that need to be obstructed
+static GstPadProbeReturn cb_analyze_detection(GstPad *pad, GstPadProbeInfo *info, ProcessJob *job)
+{
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!GST_BUFFER_PTS_IS_VALID(buffer))
+        return GST_PAD_PROBE_OK;
+
+    GstDetectionMeta *meta = GST_DETECTION_META_GET(buffer);
+    gboolean detected = meta && meta->detections->len > 0;
+    if (detected)
+    {
+        // With sparse inference, objects appeared somewhere after the last inferred frame
+        if (!job->lastDetected && job->recentFrames->len > 0)
+            g_array_append_val(job->detectionFrames, g_array_index(job->recentFrames, GstClockTime, 0));
+        g_array_append_val(job->detectionFrames, GST_BUFFER_PTS(buffer));
+    }
+    job->lastDetected = detected;
+
+    // Keep the frames of the last inference interval
+    g_array_append_val(job->recentFrames, GST_BUFFER_PTS(buffer));
+    if (job->recentFrames->len > scheduler.detectionInterval)
+        g_array_remove_index(job->recentFrames, 0);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void add_buffer_probe(GstElement *pipeline, const gchar *elementName, const gchar *padName, GstPadProbeCallback callback, ProcessJob *job)
+{
+    GstElement *element = gst_bin_get_by_name(GST_BIN(pipeline), elementName);
+    GstPad *pad = gst_element_get_static_pad(element, padName);
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, callback, job, NULL);
+    gst_object_unref(pad);
+    gst_object_unref(element);
+}
+
+// Pipeline that copies the encoded video of the input into a MPEG-TS part
+static GstElement *create_copy_pipeline(ProcessSegment *segment)
+{
+    GError *error = NULL;
+
+    gchar *inputLocation = g_strescape(segment->job->inputPath, NULL);
+    gchar *outputLocation = g_strescape(segment->outputPath, NULL);
+    gchar *description = g_strdup_printf("filesrc location=\"%s\" ! parsebin ! h264parse name=entry config-interval=-1 ! video/x-h264, stream-format=(string)byte-stream, alignment=(string)au ! mpegtsmux ! filesink name=sink location=\"%s\"", inputLocation, outputLocation);
+    GstElement *pipeline = gst_parse_launch(description, &error);
+    g_free(inputLocation);
+    g_free(outputLocation);
+    g_free(description);
+
+    if (error != NULL)
+    {
+        g_printerr("%s: unable to create copy pipeline, %s\n", segment->job->inputPath, error->message);
+        g_error_free(error);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        return NULL;
+    }
+
+    GstElement *entry = gst_bin_get_by_name(GST_BIN(pipeline), "entry");
+    pipeline_set_segment(pipeline, entry, segment->start, segment->stop);
+    gst_object_unref(entry);
+
+    return pipeline;
+}
+
+// Pipeline that joins the encoded segments without re-encoding
+static GstElement *create_concat_pipeline(ProcessSegment *segment)
+{
+    ProcessJob *job = segment->job;
+    GError *error = NULL;
+
+    // MPEG-TS takes changing stream parameters between copied and encoded parts
+    const gchar *demuxer = job->format == PIPELINE_FILE_FORMAT_TS ? "tsdemux" : "qtdemux";
+    const gchar *muxer = job->format == PIPELINE_FILE_FORMAT_TS ? "mpegtsmux" : "mp4mux";
+
+    gchar *location = g_strescape(segment->outputPath, NULL);
+    GString *description = g_string_new(NULL);
+    g_string_append_printf(description, "concat name=c ! h264parse ! %s ! filesink location=\"%s\"", muxer, location);
+    g_free(location);
+
+    for (guint i = 0; i < job->segments->len; i++)
+    {
+        ProcessSegment *part = g_ptr_array_index(job->segments, i);
+        if (part->type != PROCESS_SEGMENT_TYPE_PROCESS && part->type != PROCESS_SEGMENT_TYPE_COPY)
+            continue;
+
+        location = g_strescape(part->outputPath, NULL);
+        g_string_append_printf(description, " filesrc location=\"%s\" ! %s ! h264parse ! c.", location, demuxer);
+        g_free(location);
+    }
+
+    GstElement *pipeline = gst_parse_launch(description->str, &error);
+    g_string_free(description, TRUE);
+    if (error != NULL)
+    {
+        g_printerr("%s: unable to create concatenation, %s\n", job->inputPath, error->message);
+        g_error_free(error);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        return NULL;
+    }
+
+    return pipeline;
+}
+
+static GstElement *create_process_pipeline(ProcessSegment *segment)
+{
+    ProcessJob *job = segment->job;
+
+    PipelineFileProfile profile = scheduler.profile;
+    if (segment->type == PROCESS_SEGMENT_TYPE_ANALYZE)
+        profile.format = PIPELINE_FILE_FORMAT_NONE;
+
+    segment->sourceData = sps_source_data_new();
+    GstElement *pipeline = pipeline_file_create(segment->sourceData, TRUE, &profile);
+    if (!pipeline)
+        return NULL;
+
+    GstElement *fileSrc = gst_bin_get_by_name(GST_BIN(pipeline), "source");
+    g_object_set(G_OBJECT(fileSrc), "location", job->inputPath, NULL);
+    gst_object_unref(fileSrc);
+
+    if (segment->type == PROCESS_SEGMENT_TYPE_ANALYZE)
+    {
+        add_buffer_probe(pipeline, "videoentry", "sink", (GstPadProbeCallback)cb_analyze_keyframe, job);
+        add_buffer_probe(pipeline, "detqueue", "src", (GstPadProbeCallback)cb_analyze_detection, job);
+        foreach_detector(pipeline, (GstIteratorForeachFunction)cb_detector_record, job);
+        return pipeline;
+    }
+
+    foreach_detector(pipeline, (GstIteratorForeachFunction)cb_detector_replay, job);
+
+    GstElement *fileSink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    g_object_set(G_OBJECT(fileSink), "location", segment->outputPath, NULL);
+    gst_object_unref(fileSink);
+
+    if (GST_CLOCK_TIME_IS_VALID(segment->start))
+        pipeline_file_set_segment(pipeline, segment->start, segment->stop);
+
+    segment->stats = pipeline_stats_new();
+    pipeline_stats_attach(segment->stats, segment->sourceData);
+
+    return pipeline;
+}
+
+static gboolean process_segment_start(ProcessSegment *segment)
+{
+    ProcessJob *job = segment->job;
+
+    if (job->startTime == 0)
+        job->startTime = g_get_monotonic_time();
+
+    if (segment->type == PROCESS_SEGMENT_TYPE_COPY)
+        segment->pipeline = create_copy_pipeline(segment);
+    else if (segment->type == PROCESS_SEGMENT_TYPE_CONCAT)
+        segment->pipeline = create_concat_pipeline(segment);
+    else
+        segment->pipeline = create_process_pipeline(segment);
+    if (!segment->pipeline)
+        return FALSE;
+    gst_object_ref_sink(segment->pipeline);
+
+    GstBus *bus = gst_element_get_bus(segment->pipeline);
+    gst_bus_add_watch(bus, (GstBusFunc)cb_bus_message, segment);
+    gst_object_unref(bus);
+
+    if (gst_element_set_state(segment->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+        return FALSE;
+
+    switch (segment->type)
+    {
+    case PROCESS_SEGMENT_TYPE_ANALYZE:
+        g_print("%s: analyzing\n", job->inputPath);
+        break;
+    case PROCESS_SEGMENT_TYPE_CONCAT:
+        g_print("%s: joining %u segments into %s\n", job->inputPath, job->outputSegments, segment->outputPath);
+        break;
+    case PROCESS_SEGMENT_TYPE_COPY:
+        g_print("%s: copying segment %" GST_TIME_FORMAT " into %s\n", job->inputPath, GST_TIME_ARGS(segment->start), segment->outputPath);
+        break;
+    case PROCESS_SEGMENT_TYPE_PROCESS:
+    default:
+        if (job->outputSegments > 1)
+            g_print("%s: processing segment %" GST_TIME_FORMAT " into %s\n", job->inputPath, GST_TIME_ARGS(segment->start), segment->outputPath);
+        else
+            g_print("%s: processing into %s\n", job->inputPath, segment->outputPath);
+        break;
+    }
+
+    return TRUE;
+}
+
+static void scheduler_run_next()
+{
+    // Fill up the free pipeline slots, segments of one file run side by side
+    while (g_list_length(scheduler.runningSegments) < scheduler.maxRunningSegments && !g_queue_is_empty(scheduler.pendingSegments))
+    {
+        ProcessSegment *segment = g_queue_pop_head(scheduler.pendingSegments);
+        if (!process_segment_start(segment))
+        {
+            g_printerr("%s: unable to start processing\n", segment->job->inputPath);
+            scheduler.runningSegments = g_list_prepend(scheduler.runningSegments, segment);
+            process_segment_finish(segment, TRUE);
+            return; // Called recursively
+        }
+
+        scheduler.runningSegments = g_list_append(scheduler.runningSegments, segment);
+    }
+
+    if (scheduler.remainingJobs == 0)
+        g_main_loop_quit(scheduler.loop);
+}
+
+static gboolean cb_progress(gpointer data)
+{
+    for (GList *it = scheduler.runningSegments; it != NULL; it = it->next)
+    {
+        ProcessSegment *segment = it->data;
+
+        gint64 pos, len;
+        if (!gst_element_query_position(segment->pipeline, GST_FORMAT_TIME, &pos) || !gst_element_query_duration(segment->pipeline, GST_FORMAT_TIME, &len) || len <= 0)
+            continue;
+
+        // Report relative to the segment
+        gint64 start = GST_CLOCK_TIME_IS_VALID(segment->start) ? segment->start : 0;
+        gint64 stop = GST_CLOCK_TIME_IS_VALID(segment->stop) ? segment->stop : len;
+        if (stop > start)
+            g_print("%s: %" GST_TIME_FORMAT " %.1f%%\n", segment->job->inputPath, GST_TIME_ARGS(start), 100.0 * (pos - start) / (stop - start));
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+int main(int argc, char *argv[])
+{
+    // Init GStreamer
+    gst_init(&argc, &argv);
+
+    // Parse command line args
+    const char *pluginPath = NULL, *gstElementsPath = NULL, *outputDir = NULL, *format = NULL, *preset = NULL;
+    gboolean passthrough = FALSE;
+    gint jobCount = DEFAULT_JOB_COUNT, segmentCount = DEFAULT_SEGMENT_COUNT, detectionInterval = 1;
+    gchar **inputPaths = NULL;
+    GOptionContext *context = g_option_context_new("FILE... - redact video files without user interface");
+    GError *error = NULL;
+    GOptionEntry entries[] =
+    {
+        { "plugins", 'p', 0, G_OPTION_ARG_STRING, &pluginPath, "Path to SPS plugins directory", "plugin-path" },
+        { "gst-elements", 'g', 0, G_OPTION_ARG_STRING, &gstElementsPath, "Path to GStreamer elements", "gstreamer-elements-path" },
+        { "jobs", 'j', 0, G_OPTION_ARG_INT, &jobCount, "Number of pipelines running concurrently", "count" },
+        { "segments", 's', 0, G_OPTION_ARG_INT, &segmentCount, "Number of segments every file is split into for parallel processing (mp4 and ts only)", "count" },
+        { "output-dir", 'o', 0, G_OPTION_ARG_FILENAME, &outputDir, "Directory for the processed files (default: next to the input)", "directory" },
+        { "format", 'f', 0, G_OPTION_ARG_STRING, &format, "Output format, mp4 (default), webm, ts or ogv", "format" },
+        { "preset", 'e', 0, G_OPTION_ARG_STRING, &preset, "Encoder preset, fast, balanced (default) or quality", "preset" },
+        { "detection-interval", 'd', 0, G_OPTION_ARG_INT, &detectionInterval, "Run object detection on every n-th frame in a first pass, then only where detections change", "frames" },
+        { "passthrough", 't', 0, G_OPTION_ARG_NONE, &passthrough, "Only re-encode the parts of H.264 inputs that need to be obstructed (ts output)", NULL },
+        { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &inputPaths, NULL, "FILE..." },
+        { NULL }
+    };
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error))
+    {
+        g_printerr("Option parsing failed: %s\n", error->message);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    if (inputPaths == NULL || jobCount < 1 || segmentCount < 1 || detectionInterval < 1)
+    {
+        g_printerr("Missing input files or invalid job, segment count or detection interval. Use --help for more information.\n");
+        return 1;
+    }
+
+    if (gstElementsPath == NULL || pluginPath == NULL)
+    {
+        g_printerr("Missing GStreamer elements or plugin path. Use --help for more information.\n");
+        return 1;
+    }
+
+    // Add custom registry path for gstreamer plugins and load sps plugins
+    gst_registry_scan_path(gst_registry_get(), gstElementsPath);
+    sps_registry_scan_path(sps_registry_get(), pluginPath);
+
+    // Setup scheduler
+    scheduler.loop = g_main_loop_new(NULL, FALSE);
+    scheduler.pendingSegments = g_queue_new();
+    scheduler.maxRunningSegments = jobCount;
+    scheduler.outputDir = outputDir;
+    scheduler.segmentCount = segmentCount;
+    scheduler.passthrough = passthrough;
+    scheduler.detectionInterval = detectionInterval;
+
+    if (format == NULL || g_str_equal(format, "mp4"))
+        scheduler.profile.format = PIPELINE_FILE_FORMAT_MP4;
+    else if (g_str_equal(format, "webm"))
+        scheduler.profile.format = PIPELINE_FILE_FORMAT_WEBM;
+    else if (g_str_equal(format, "ts"))
+        scheduler.profile.format = PIPELINE_FILE_FORMAT_TS;
+    else if (g_str_equal(format, "ogv"))
+        scheduler.profile.format = PIPELINE_FILE_FORMAT_OGG;
+    else
+    {
+        g_printerr("Unknown output format %s. Use --help for more information.\n", format);
+        return 1;
+    }
+
+    if (preset == NULL || g_str_equal(preset, "balanced"))
+        scheduler.profile.preset = PIPELINE_ENCODER_PRESET_BALANCED;
+    else if (g_str_equal(preset, "fast"))
+        scheduler.profile.preset = PIPELINE_ENCODER_PRESET_FAST;
+    else if (g_str_equal(preset, "quality"))
+        scheduler.profile.preset = PIPELINE_ENCODER_PRESET_QUALITY;
+    else
+    {
+        g_printerr("Unknown encoder preset %s. Use --help for more information.\n", preset);
+        return 1;
+    }
+
+    // Copied and encoded parts are joined in MPEG-TS, so passthrough implies it
+    if (passthrough)
+    {
+        scheduler.profile.format = PIPELINE_FILE_FORMAT_TS;
+        scheduler.segmentCount = 1;
+    }
+
+    // Only H.264 streams can be joined without re-encoding
+    if (scheduler.profile.format != PIPELINE_FILE_FORMAT_MP4 && scheduler.profile.format != PIPELINE_FILE_FORMAT_TS && segmentCount > 1)
+    {
+        g_printerr("Segmented processing is only supported for mp4 and ts output.\n");
+        return 1;
+    }
+
+    for (gchar **inputPath = inputPaths; *inputPath != NULL; inputPath++)
+    {
+        process_job_new(*inputPath);
+        scheduler.remainingJobs++;
+    }
+
+    // Process all files
+    gint64 startTime = g_get_monotonic_time();
+    g_timeout_add_seconds(PROGRESS_INTERVAL, cb_progress, NULL);
+    scheduler_run_next();
+    if (scheduler.remainingJobs > 0)
+        g_main_loop_run(scheduler.loop);
+
+    gdouble seconds = (g_get_monotonic_time() - startTime) / (gdouble)G_USEC_PER_SEC;
+    g_print("Processed %" G_GUINT64_FORMAT " frames in %.1f s (%.1f fps), %u failed\n", scheduler.totalFrames, seconds, seconds > 0 ? scheduler.totalFrames / seconds : 0, scheduler.failedJobs);
+
+    // Free memory
+    g_main_loop_unref(scheduler.loop);
+    g_queue_free(scheduler.pendingSegments);
+    g_strfreev(inputPaths);
+    g_free((void *)pluginPath);
+    g_free((void *)gstElementsPath);
+    g_free((void *)outputDir);
+    g_free((void *)format);
+    g_free((void *)preset);
+
+    return scheduler.failedJobs > 0 ? 1 : 0;
+}
@@ -1,7 +1,7 @@
 # Install SPS application
 
 # ----------- Basic installation rules for binary and library
-install (TARGETS smart-privacy-shield
+install (TARGETS smart-privacy-shield sps-process
   EXPORT SpsTargets DESTINATION ${LIB_DIR}
   RUNTIME DESTINATION ${BIN_DIR}
   LIBRARY DESTINATION ${LIB_DIR}
@@ -8,6 +8,8 @@
 #include "gui/file-processor-window.h"
 #include "gui/dialog-preferences.h"
 #include "pipeline.h"
+#include "sourcestats.h"
+#include "gui/source-row.h"
 
 G_DEFINE_TYPE(SpsApplication, sps_application, GTK_TYPE_APPLICATION);
 
@@ -69,6 +71,52 @@ static GActionEntry actions[] = {
 };
 
 // Pipeline callbacks
+static void sps_application_pipeline_element(GstBus *bus, GstMessage *msg, gpointer self)
+{
+    SpsApplication *app = SPS_APPLICATION(self);
+
+    // Processing stats of the elements are collected per source and shown at a fixed rate
+    for (guint i = 0; i < app->gstData.sources->len; i++)
+    {
+        SpsSourceData *sourceData = g_ptr_array_index(app->gstData.sources, i);
+        if (source_stats_handle_message(sourceData->stats, sourceData, msg))
+            break;
+    }
+}
+
+static gboolean cb_refresh_stats(gpointer self)
+{
+    SpsApplication *app = SPS_APPLICATION(self);
+
+    for (guint i = 0; i < app->gstData.sources->len; i++)
+    {
+        SpsSourceData *sourceData = g_ptr_array_index(app->gstData.sources, i);
+        source_stats_refresh(sourceData->stats, sourceData);
+        sps_source_row_update_stats(sourceData->row, TRUE);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void sps_application_set_stats_refresh(SpsApplication *app, gboolean running)
+{
+    if (running && !app->gstData.statsTimeoutId)
+        app->gstData.statsTimeoutId = g_timeout_add_seconds(SOURCE_STATS_REFRESH_INTERVAL, cb_refresh_stats, app);
+
+    if (!running && app->gstData.statsTimeoutId)
+    {
+        g_source_remove(app->gstData.statsTimeoutId);
+        app->gstData.statsTimeoutId = 0;
+
+        for (guint i = 0; i < app->gstData.sources->len; i++)
+        {
+            SpsSourceData *sourceData = g_ptr_array_index(app->gstData.sources, i);
+            source_stats_reset(sourceData->stats);
+            sps_source_row_update_stats(sourceData->row, FALSE);
+        }
+    }
+}
+
 static void sps_application_pipeline_state_changed(GstBus *bus, GstMessage *msg, gpointer self)
 {
     SpsApplication *app = SPS_APPLICATION(self);
@@ -86,6 +134,7 @@ static void sps_application_pipeline_state_changed(GstBus *bus, GstMessage *msg,
         if (newState < oldState && newState < GST_STATE_PAUSED)
             gtk_widget_hide(GTK_WIDGET(app->videoWindow));
 
+        sps_application_set_stats_refresh(app, newState == GST_STATE_PLAYING);
         sps_main_window_update_ui(app->mainWindow);
         sps_application_update_menu(app);
     }
@@ -112,6 +161,7 @@ static gboolean sps_application_pipeline_init(SpsApplication *app)
     GstBus *bus = gst_element_get_bus(app->gstData.pipeline);
     gst_bus_add_signal_watch(bus);
     g_signal_connect(G_OBJECT(bus), "message::state-changed", (GCallback)sps_application_pipeline_state_changed, (gpointer)app);
+    g_signal_connect(G_OBJECT(bus), "message::element", (GCallback)sps_application_pipeline_element, (gpointer)app);
     gst_object_unref(bus);
 
     // Put pipeline to ready state
@@ -193,6 +243,8 @@ static void sps_application_shutdown(GApplication *parent)
 {
     SpsApplication *app = SPS_APPLICATION(parent);
 
+    if (app->gstData.statsTimeoutId)
+        g_source_remove(app->gstData.statsTimeoutId);
     gst_element_set_state(app->gstData.pipeline, GST_STATE_NULL);
     gst_object_unref(app->gstData.pipeline);
 
@@ -24,6 +24,7 @@ struct _GstData
 {
     GstElement *pipeline; // Main pipeline
     GPtrArray *sources;   // Stores all added sources in a SourceData struct
+    guint statsTimeoutId; // Refreshes the stats of the source rows while the pipeline is playing
 };
 
 struct _SpsApplication
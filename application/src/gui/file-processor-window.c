@@ -88,7 +88,11 @@ static void pipeline_eos(GstBus *bus, GstMessage *msg, gpointer self)
 
 static void sps_file_processor_window_pipeline_init(SpsFileProcessorWindow *window)
 {
-    window->pipeline = pipeline_file_create(window->sourceData, TRUE);
+    PipelineFileProfile profile = {
+        .format = PIPELINE_FILE_FORMAT_OGG,
+        .preset = PIPELINE_ENCODER_PRESET_BALANCED,
+    };
+    window->pipeline = pipeline_file_create(window->sourceData, TRUE, &profile);
 
     // Register for important bus events
     GstBus *bus = gst_element_get_bus(window->pipeline);
@@ -1,6 +1,7 @@
 #include <gtk/gtk.h>
 #include "source-row.h"
 #include "../sourcedata.h"
+#include "../sourcestats.h"
 #include "main-window.h"
 #include "dialog-edit-source.h"
 
@@ -46,6 +47,7 @@ static void sps_source_row_class_init(SpsSourceRowClass *klass)
 
     // Register elements
     gtk_widget_class_bind_template_child(widget_class, SpsSourceRow, lblName);
+    gtk_widget_class_bind_template_child(widget_class, SpsSourceRow, lblStats);
     gtk_widget_class_bind_template_child(widget_class, SpsSourceRow, btnRemove);
     gtk_widget_class_bind_template_child(widget_class, SpsSourceRow, btnEdit);
 
@@ -61,3 +63,17 @@ SpsSourceRow *sps_source_row_new(SpsSourceData *sourceData)
 
     return row;
 }
+
+// Show the latest processing stats of the source, cleared while the pipeline is not running
+void sps_source_row_update_stats(SpsSourceRow *row, gboolean running)
+{
+    if (!running)
+    {
+        gtk_label_set_text(GTK_LABEL(row->lblStats), "");
+        return;
+    }
+
+    gchar *text = source_stats_to_string(row->sourceData->stats);
+    gtk_label_set_text(GTK_LABEL(row->lblStats), text);
+    g_free(text);
+}
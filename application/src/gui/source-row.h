@@ -23,6 +23,7 @@ struct _SpsSourceRow
   SpsSourceData *sourceData;
 
   GtkWidget *lblName;
+  GtkWidget *lblStats;
   GtkWidget *btnRemove;
   GtkWidget *btnEdit;
 };
@@ -35,3 +36,4 @@ struct _SpsSourceRowClass
 G_END_DECLS
 
 SpsSourceRow *sps_source_row_new(SpsSourceData *data);
+void sps_source_row_update_stats(SpsSourceRow *row, gboolean running);
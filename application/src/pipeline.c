@@ -3,6 +3,17 @@
 #include <gst/pbutils/encoding-profile.h>
 #include "sourcedata.h"
 #include "pipeline.h"
+#include "sourcestats.h"
+
+typedef struct _SegmentData SegmentData;
+struct _SegmentData
+{
+    GstElement *pipeline;
+    GstPad *pad;
+    gulong probeId;
+    GstClockTime start, stop;
+    gboolean seekRequested;
+};
 
 typedef struct _PipelineData PipelineData;
 struct _PipelineData
@@ -89,8 +100,66 @@ static GstEncodingContainerProfile *create_ogg_profile(gboolean hasVideo, gboole
     return containerProfile;
 }
 
+// Profile for a single video stream in a container
+static GstEncodingContainerProfile *create_video_profile(const char *name, const char *containerCaps, const char *videoCaps)
+{
+    GstEncodingContainerProfile *containerProfile;
+
+    GstCaps *profileCaps = gst_caps_from_string(containerCaps);
+    containerProfile = gst_encoding_container_profile_new(name, NULL, profileCaps, NULL);
+    gst_caps_unref(profileCaps);
+
+    GstCaps *caps = gst_caps_from_string(videoCaps);
+    gst_encoding_container_profile_add_profile(containerProfile, (GstEncodingProfile *)gst_encoding_video_profile_new(caps, NULL, NULL, 0));
+    gst_caps_unref(caps);
+
+    return containerProfile;
+}
+
+// Configure the encoder created by encodebin according to the preset
+static void pipeline_file_encoder_element_added(GstBin *bin, GstBin *subBin, GstElement *element, gpointer data)
+{
+    PipelineEncoderPreset preset = GPOINTER_TO_INT(data);
+    GstElementFactory *factory = gst_element_get_factory(element);
+    if (!factory)
+        return;
+
+    const char *factoryName = GST_OBJECT_NAME(factory);
+    if (g_str_equal(factoryName, "x264enc"))
+    {
+        static const char *speedPresets[] = {"ultrafast", "veryfast", "medium"};
+        gst_util_set_object_arg(G_OBJECT(element), "speed-preset", speedPresets[preset]);
+    }
+    else if (g_str_equal(factoryName, "vp8enc"))
+    {
+        static const gint cpuUsed[] = {16, 4, 0};
+        g_object_set(element, "deadline", (gint64)(preset == PIPELINE_ENCODER_PRESET_QUALITY ? 0 : 1), "cpu-used", cpuUsed[preset], "threads", g_get_num_processors(), NULL);
+    }
+    else if (g_str_equal(factoryName, "theoraenc"))
+    {
+        static const gint speedLevels[] = {2, 1, 0};
+        g_object_set(element, "speed-level", speedLevels[preset], NULL);
+    }
+}
+
+const char *pipeline_file_format_get_extension(PipelineFileFormat format)
+{
+    switch (format)
+    {
+    case PIPELINE_FILE_FORMAT_MP4:
+        return "mp4";
+    case PIPELINE_FILE_FORMAT_WEBM:
+        return "webm";
+    case PIPELINE_FILE_FORMAT_TS:
+        return "ts";
+    case PIPELINE_FILE_FORMAT_OGG:
+    default:
+        return "ogv";
+    }
+}
+
 // Create and manage file pipeline
-GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultElements)
+GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultElements, const PipelineFileProfile *fileProfile)
 {
     // Create pipeline
     GstElement *pipeline = gst_pipeline_new("file-pipeline");
@@ -181,6 +250,25 @@ GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultE
         return NULL;
     }
 
+    // Without output, frames are only analyzed
+    if (fileProfile->format == PIPELINE_FILE_FORMAT_NONE)
+    {
+        GstElement *sink = gst_element_factory_make("fakesink", "sink");
+        if (!sink)
+        {
+            GST_ERROR("Unable to create sink");
+            return NULL;
+        }
+        gst_bin_add(GST_BIN(pipeline), sink);
+        if (!gst_element_link(postprocessorQueue, sink))
+        {
+            GST_ERROR("Unable to link postprocessor queue to sink");
+            return NULL;
+        }
+
+        goto default_elements;
+    }
+
     // Add encoder
     GstElement *encoder = gst_element_factory_make("encodebin", "encoder");
     if (!encoder)
@@ -189,8 +277,25 @@ GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultE
         return NULL;
     }
     gst_bin_add(GST_BIN(pipeline), encoder);
-    GstEncodingContainerProfile *profile = create_ogg_profile(TRUE, FALSE);
+    GstEncodingContainerProfile *profile;
+    switch (fileProfile->format)
+    {
+    case PIPELINE_FILE_FORMAT_MP4:
+        profile = create_video_profile("mp4/h264", "video/quicktime, variant=(string)iso", "video/x-h264");
+        break;
+    case PIPELINE_FILE_FORMAT_WEBM:
+        profile = create_video_profile("webm/vp8", "video/webm", "video/x-vp8");
+        break;
+    case PIPELINE_FILE_FORMAT_TS:
+        profile = create_video_profile("ts/h264", "video/mpegts, systemstream=(boolean)true, packetsize=(int)188", "video/x-h264, stream-format=(string)byte-stream");
+        break;
+    case PIPELINE_FILE_FORMAT_OGG:
+    default:
+        profile = create_ogg_profile(TRUE, FALSE);
+        break;
+    }
     g_object_set(encoder, "profile", profile, NULL);
+    g_signal_connect(encoder, "deep-element-added", G_CALLBACK(pipeline_file_encoder_element_added), GINT_TO_POINTER(fileProfile->preset));
 
     // Link postprocessorQueue to encoder
     GstPad *postprocessorQueueSrcPad = gst_element_get_static_pad(postprocessorQueue, "src");
@@ -216,6 +321,7 @@ GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultE
         return NULL;
     };
 
+default_elements:
     if (!addDefaultElements)
         return pipeline;
 
@@ -245,6 +351,76 @@ GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultE
     return pipeline;
 }
 
+static gboolean cb_seek_segment(SegmentData *data)
+{
+    GstElement *pipeline = data->pipeline;
+    GstPad *pad = gst_object_ref(data->pad);
+    gulong probeId = data->probeId;
+
+    // The seek flushes the pipeline, which removes the probe and frees the data
+    GstEvent *seek = gst_event_new_seek(1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+                                        GST_SEEK_TYPE_SET, data->start, GST_SEEK_TYPE_SET, data->stop);
+    if (!gst_pad_push_event(pad, seek))
+    {
+        gst_pad_remove_probe(pad, probeId);
+        GST_ELEMENT_ERROR(pipeline, STREAM, FAILED, ("Unable to seek to segment"), (NULL));
+    }
+
+    gst_object_unref(pad);
+
+    return G_SOURCE_REMOVE;
+}
+
+static GstPadProbeReturn cb_segment_probe(GstPad *pad, GstPadProbeInfo *info, SegmentData *data)
+{
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+        // Upstream is set up once data flows, so we are able to seek now
+        if (!data->seekRequested)
+        {
+            data->seekRequested = TRUE;
+            g_idle_add(G_SOURCE_FUNC(cb_seek_segment), data);
+        }
+
+        // Data before the segment never reaches the processors
+        return GST_PAD_PROBE_DROP;
+    }
+
+    // Everything after the flush belongs to the segment
+    if (data->seekRequested && GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_FLUSH_STOP)
+        return GST_PAD_PROBE_REMOVE;
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void segment_data_free(SegmentData *data)
+{
+    gst_object_unref(data->pad);
+    g_free(data);
+}
+
+// Limit a pipeline to the given time range of its input, must be called before starting the pipeline.
+// Data reaching the entry element before the seek is dropped.
+void pipeline_set_segment(GstElement *pipeline, GstElement *entry, GstClockTime start, GstClockTime stop)
+{
+    SegmentData *data = g_new0(SegmentData, 1);
+    data->pipeline = pipeline;
+    data->pad = gst_element_get_static_pad(entry, "sink");
+    data->start = start;
+    data->stop = stop;
+
+    // Seek requests are sent upstream from the entry, as muxers do not forward them
+    data->probeId = gst_pad_add_probe(data->pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH, (GstPadProbeCallback)cb_segment_probe, data, (GDestroyNotify)segment_data_free);
+}
+
+// Limit a file pipeline to the given time range of the input
+void pipeline_file_set_segment(GstElement *pipeline, GstClockTime start, GstClockTime stop)
+{
+    GstElement *videoentry = gst_bin_get_by_name(GST_BIN(pipeline), "videoentry");
+    pipeline_set_segment(pipeline, videoentry, start, stop);
+    gst_object_unref(videoentry);
+}
+
 // Create and manage main pipe
 GstElement *pipeline_main_create()
 {
@@ -483,6 +659,9 @@ GstElement *pipeline_subpipe_create(SpsSourceData *sourceData, gboolean addDefau
     gst_element_add_pad(subpipe, ghostPad);
     gst_object_unref(pad);
 
+    // Count the frames the leaky queues drop
+    source_stats_attach(sourceData->stats, sourceData);
+
     if (!addDefaultElements)
         return subpipe;
 
@@ -3,7 +3,38 @@
 #include <gst/gst.h>
 #include "sourcedata.h"
 
-GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultElements);
+typedef enum _PipelineFileFormat PipelineFileFormat;
+enum _PipelineFileFormat
+{
+    PIPELINE_FILE_FORMAT_OGG,  // Theora in Ogg
+    PIPELINE_FILE_FORMAT_MP4,  // H.264 in MP4, considerably faster to encode
+    PIPELINE_FILE_FORMAT_WEBM, // VP8 in WebM
+    PIPELINE_FILE_FORMAT_TS,   // H.264 in MPEG-TS, streams with different encoder settings can be joined
+    PIPELINE_FILE_FORMAT_NONE, // No output, frames are only analyzed
+};
+
+typedef enum _PipelineEncoderPreset PipelineEncoderPreset;
+enum _PipelineEncoderPreset
+{
+    PIPELINE_ENCODER_PRESET_FAST,
+    PIPELINE_ENCODER_PRESET_BALANCED,
+    PIPELINE_ENCODER_PRESET_QUALITY,
+};
+
+typedef struct _PipelineFileProfile PipelineFileProfile;
+struct _PipelineFileProfile
+{
+    PipelineFileFormat format;
+    PipelineEncoderPreset preset;
+};
+
+const char *pipeline_file_format_get_extension(PipelineFileFormat format);
+
+GstElement *pipeline_file_create(SpsSourceData *sourceData, gboolean addDefaultElements, const PipelineFileProfile *fileProfile);
+
+void pipeline_set_segment(GstElement *pipeline, GstElement *entry, GstClockTime start, GstClockTime stop);
+
+void pipeline_file_set_segment(GstElement *pipeline, GstClockTime start, GstClockTime stop);
 
 GstElement *pipeline_main_create();
 
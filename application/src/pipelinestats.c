@@ -0,0 +1,171 @@
+#include <gst/gst.h>
+#include "sourcedata.h"
+#include "pipelinestats.h"
+
+typedef struct _PipelineStatsProbe PipelineStatsProbe;
+struct _PipelineStatsProbe
+{
+    PipelineStats *stats;
+    PipelineStage stage;
+};
+
+typedef struct _PipelineStatsEntry PipelineStatsEntry;
+struct _PipelineStatsEntry
+{
+    GstClockTime pts;
+    gint64 time;
+};
+
+const char *pipeline_stage_get_name(PipelineStage stage)
+{
+    switch (stage)
+    {
+    case PIPELINE_STAGE_PREPROCESSING:
+        return "preprocessing";
+    case PIPELINE_STAGE_DETECTION:
+        return "detection";
+    case PIPELINE_STAGE_POSTPROCESSING:
+        return "postprocessing";
+    default:
+        return "unknown";
+    }
+}
+
+PipelineStats *pipeline_stats_new()
+{
+    PipelineStats *stats = g_new0(PipelineStats, 1);
+
+    g_mutex_init(&stats->mtxStats);
+    for (gint i = 0; i < PIPELINE_STAGE_COUNT; i++)
+        stats->pending[i] = g_queue_new();
+
+    return stats;
+}
+
+static GstPadProbeReturn cb_stage_enter(GstPad *pad, GstPadProbeInfo *info, PipelineStatsProbe *probe)
+{
+    PipelineStats *stats = probe->stats;
+
+    PipelineStatsEntry *entry = g_new(PipelineStatsEntry, 1);
+    entry->pts = GST_BUFFER_PTS(GST_PAD_PROBE_INFO_BUFFER(info));
+    entry->time = g_get_monotonic_time();
+
+    g_mutex_lock(&stats->mtxStats);
+    g_queue_push_tail(stats->pending[probe->stage], entry);
+    g_mutex_unlock(&stats->mtxStats);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn cb_stage_leave(GstPad *pad, GstPadProbeInfo *info, PipelineStatsProbe *probe)
+{
+    PipelineStats *stats = probe->stats;
+    GstClockTime pts = GST_BUFFER_PTS(GST_PAD_PROBE_INFO_BUFFER(info));
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(&stats->mtxStats);
+
+    // Frames leave a stage in order, entries of frames that were dropped inside the stage are skipped
+    PipelineStatsEntry *entry;
+    while ((entry = g_queue_pop_head(stats->pending[probe->stage])) != NULL)
+    {
+        gboolean match = entry->pts == pts;
+        if (match)
+        {
+            stats->stageTime[probe->stage] += now - entry->time;
+            stats->stageFrames[probe->stage]++;
+        }
+        g_free(entry);
+
+        if (match)
+            break;
+    }
+
+    if (probe->stage == PIPELINE_STAGE_POSTPROCESSING)
+        stats->frames++;
+
+    g_mutex_unlock(&stats->mtxStats);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void pipeline_stats_add_probe(PipelineStats *stats, GstElement *element, const char *padName, PipelineStage stage, gboolean enter)
+{
+    if (!element)
+    {
+        GST_WARNING("Unable to measure %s stage", pipeline_stage_get_name(stage));
+        return;
+    }
+
+    PipelineStatsProbe *probe = g_new(PipelineStatsProbe, 1);
+    probe->stats = stats;
+    probe->stage = stage;
+
+    GstPad *pad = gst_element_get_static_pad(element, padName);
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, (GstPadProbeCallback)(enter ? cb_stage_enter : cb_stage_leave), probe, g_free);
+    gst_object_unref(pad);
+}
+
+// Measure the time frames spend in between the decoupling queues of a file pipeline
+void pipeline_stats_attach(PipelineStats *stats, SpsSourceData *sourceData)
+{
+    GstElement *videoentry = gst_bin_get_by_name(GST_BIN(sourceData->pipeline), "videoentry");
+
+    pipeline_stats_add_probe(stats, videoentry, "src", PIPELINE_STAGE_PREPROCESSING, TRUE);
+    pipeline_stats_add_probe(stats, sourceData->preprocessorQueue, "sink", PIPELINE_STAGE_PREPROCESSING, FALSE);
+    pipeline_stats_add_probe(stats, sourceData->preprocessorQueue, "src", PIPELINE_STAGE_DETECTION, TRUE);
+    pipeline_stats_add_probe(stats, sourceData->detectorQueue, "sink", PIPELINE_STAGE_DETECTION, FALSE);
+    pipeline_stats_add_probe(stats, sourceData->detectorQueue, "src", PIPELINE_STAGE_POSTPROCESSING, TRUE);
+    pipeline_stats_add_probe(stats, sourceData->postprocessorQueue, "sink", PIPELINE_STAGE_POSTPROCESSING, FALSE);
+
+    if (videoentry)
+        gst_object_unref(videoentry);
+}
+
+// Average processing time of a stage in milliseconds
+gdouble pipeline_stats_get_stage_average(PipelineStats *stats, PipelineStage stage)
+{
+    gdouble average = 0;
+
+    g_mutex_lock(&stats->mtxStats);
+    if (stats->stageFrames[stage] > 0)
+        average = stats->stageTime[stage] / 1000.0 / stats->stageFrames[stage];
+    g_mutex_unlock(&stats->mtxStats);
+
+    return average;
+}
+
+guint64 pipeline_stats_get_frames(PipelineStats *stats)
+{
+    g_mutex_lock(&stats->mtxStats);
+    guint64 frames = stats->frames;
+    g_mutex_unlock(&stats->mtxStats);
+
+    return frames;
+}
+
+// Add the measurements of another pipeline, e.g. to combine the segments of a file
+void pipeline_stats_accumulate(PipelineStats *target, PipelineStats *source)
+{
+    g_mutex_lock(&source->mtxStats);
+    g_mutex_lock(&target->mtxStats);
+
+    target->frames += source->frames;
+    for (gint i = 0; i < PIPELINE_STAGE_COUNT; i++)
+    {
+        target->stageTime[i] += source->stageTime[i];
+        target->stageFrames[i] += source->stageFrames[i];
+    }
+
+    g_mutex_unlock(&target->mtxStats);
+    g_mutex_unlock(&source->mtxStats);
+}
+
+// Only free once the pipeline has been disposed, the probes reference the stats
+void pipeline_stats_free(PipelineStats *stats)
+{
+    for (gint i = 0; i < PIPELINE_STAGE_COUNT; i++)
+        g_queue_free_full(stats->pending[i], g_free);
+    g_mutex_clear(&stats->mtxStats);
+    g_free(stats);
+}
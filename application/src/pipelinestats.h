@@ -0,0 +1,38 @@
+#pragma once
+
+#include <gst/gst.h>
+#include "sourcedata.h"
+
+typedef enum _PipelineStage PipelineStage;
+enum _PipelineStage
+{
+    PIPELINE_STAGE_PREPROCESSING,
+    PIPELINE_STAGE_DETECTION,
+    PIPELINE_STAGE_POSTPROCESSING,
+    PIPELINE_STAGE_COUNT,
+};
+
+typedef struct _PipelineStats PipelineStats;
+struct _PipelineStats
+{
+    GMutex mtxStats;
+
+    guint64 frames;                              // Frames that left the postprocessors
+    GQueue *pending[PIPELINE_STAGE_COUNT];       // Frames that entered a stage but did not leave it yet
+    gint64 stageTime[PIPELINE_STAGE_COUNT];      // Accumulated processing time per stage in microseconds
+    guint64 stageFrames[PIPELINE_STAGE_COUNT];   // Frames that passed a stage
+};
+
+const char *pipeline_stage_get_name(PipelineStage stage);
+
+PipelineStats *pipeline_stats_new();
+
+void pipeline_stats_attach(PipelineStats *stats, SpsSourceData *sourceData);
+
+gdouble pipeline_stats_get_stage_average(PipelineStats *stats, PipelineStage stage);
+
+guint64 pipeline_stats_get_frames(PipelineStats *stats);
+
+void pipeline_stats_accumulate(PipelineStats *target, PipelineStats *source);
+
+void pipeline_stats_free(PipelineStats *stats);
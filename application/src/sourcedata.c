@@ -1,6 +1,7 @@
 #include <gst/gst.h>
 #include <gtk/gtk.h>
 #include "sourcedata.h"
+#include "sourcestats.h"
 
 G_DEFINE_TYPE(SpsSourceData, sps_source_data, G_TYPE_OBJECT);
 
@@ -13,6 +14,8 @@ void sps_source_data_init(SpsSourceData *self)
     self->activePreprocessorElements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
     self->activeDetectorElements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
     self->activePostprocessorElements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    self->stats = source_stats_new();
 }
 
 void sps_source_data_finalize(GObject *object)
@@ -27,6 +30,7 @@ void sps_source_data_finalize(GObject *object)
     g_hash_table_destroy(self->activeDetectorElements);
     g_hash_table_destroy(self->activePostprocessorElements);
 
+    source_stats_free(self->stats);
     sps_source_info_clear(&self->sourceInfo);
 
     G_OBJECT_CLASS(sps_source_data_parent_class)->finalize(object);
@@ -7,6 +7,7 @@
 // Forward declarations to prevent circular dependency
 typedef struct _SpsMainWindow SpsMainWindow;
 typedef struct _SpsSourceRow SpsSourceRow;
+typedef struct _SourceStats SourceStats;
 
 G_BEGIN_DECLS
 
@@ -28,6 +29,7 @@ struct _SpsSourceData
     SpsSourceInfo sourceInfo;
 
     SpsSourceRow *row;
+    SourceStats *stats; // Live processing stats shown in the row
 
     GstElement *pipeline;
     GstElement *preprocessorQueue, *detectorQueue, *postprocessorQueue;
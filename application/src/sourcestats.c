@@ -0,0 +1,209 @@
+#include <gst/gst.h>
+#include "sourcedata.h"
+#include "sourcestats.h"
+
+#define SOURCE_STATS_MESSAGE_NAME "sps-processing-stats" // See processingstats.h of the common plugin library
+#define SOURCE_STATS_MAX_AGE (3 * G_USEC_PER_SEC)        // Samples of elements that stopped reporting are dropped after this time
+
+typedef struct _SourceStatsQueue SourceStatsQueue;
+struct _SourceStatsQueue
+{
+    SourceStats *stats;
+    PipelineStage stage;
+};
+
+SourceStats *source_stats_new()
+{
+    SourceStats *stats = g_new0(SourceStats, 1);
+
+    stats->samples = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    stats->previousSamples = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    return stats;
+}
+
+static void cb_queue_overrun(GstElement *queue, SourceStatsQueue *data)
+{
+    // A full leaky queue drops its oldest frame for every new one
+    g_atomic_int_inc(&data->stats->leaked[data->stage]);
+}
+
+static void source_stats_connect_queue(SourceStats *stats, GstElement *queue, PipelineStage stage)
+{
+    SourceStatsQueue *data = g_new(SourceStatsQueue, 1);
+    data->stats = stats;
+    data->stage = stage;
+
+    g_signal_connect_data(queue, "overrun", G_CALLBACK(cb_queue_overrun), data, (GClosureNotify)g_free, 0);
+}
+
+// Count the frames the leaky queues of a live subpipe drop. Only free the stats once the subpipe has been disposed.
+void source_stats_attach(SourceStats *stats, SpsSourceData *sourceData)
+{
+    source_stats_connect_queue(stats, sourceData->preprocessorQueue, PIPELINE_STAGE_PREPROCESSING);
+    source_stats_connect_queue(stats, sourceData->detectorQueue, PIPELINE_STAGE_DETECTION);
+    source_stats_connect_queue(stats, sourceData->postprocessorQueue, PIPELINE_STAGE_POSTPROCESSING);
+}
+
+static gboolean is_stage_element(GHashTable *elements, GstObject *object)
+{
+    GHashTableIter iter;
+    gpointer element;
+
+    // Plugins may wrap their elements in bins
+    g_hash_table_iter_init(&iter, elements);
+    while (g_hash_table_iter_next(&iter, NULL, &element))
+    {
+        if (object == GST_OBJECT(element) || gst_object_has_as_ancestor(object, GST_OBJECT(element)))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gint get_stage(SpsSourceData *sourceData, GstObject *object)
+{
+    if (is_stage_element(sourceData->activePreprocessorElements, object))
+        return PIPELINE_STAGE_PREPROCESSING;
+    if (is_stage_element(sourceData->activeDetectorElements, object))
+        return PIPELINE_STAGE_DETECTION;
+    if (is_stage_element(sourceData->activePostprocessorElements, object))
+        return PIPELINE_STAGE_POSTPROCESSING;
+
+    return -1;
+}
+
+// Store the stats an element of the source posted. Returns FALSE if the message is not meant for this source.
+gboolean source_stats_handle_message(SourceStats *stats, SpsSourceData *sourceData, GstMessage *msg)
+{
+    const GstStructure *structure = gst_message_get_structure(msg);
+    GstObject *src = GST_MESSAGE_SRC(msg);
+
+    if (!structure || !gst_structure_has_name(structure, SOURCE_STATS_MESSAGE_NAME))
+        return FALSE;
+    if (!sourceData->pipeline || !gst_object_has_as_ancestor(src, GST_OBJECT(sourceData->pipeline)))
+        return FALSE;
+
+    SourceStatsSample *sample = g_new0(SourceStatsSample, 1);
+    sample->stage = get_stage(sourceData, src);
+    sample->time = g_get_monotonic_time();
+    gst_structure_get_uint64(structure, "buffers", &sample->buffers);
+    gst_structure_get_uint64(structure, "total", &sample->totalTime);
+
+    // Keep the previous sample, the difference between both covers the last interval
+    gchar *name = GST_OBJECT_NAME(src);
+    SourceStatsSample *previous = g_hash_table_lookup(stats->samples, name);
+    if (previous)
+    {
+        g_hash_table_steal(stats->samples, name);
+        g_hash_table_replace(stats->previousSamples, g_strdup(name), previous);
+    }
+    g_hash_table_replace(stats->samples, g_strdup(name), sample);
+
+    return TRUE;
+}
+
+static gdouble get_queue_fill(GstElement *queue)
+{
+    guint buffers, maxBuffers;
+    guint64 time, maxTime;
+    gdouble fill = 0;
+
+    g_object_get(queue,
+                 "current-level-buffers", &buffers, "max-size-buffers", &maxBuffers,
+                 "current-level-time", &time, "max-size-time", &maxTime,
+                 NULL);
+
+    // The queue leaks as soon as one of its limits is reached
+    if (maxBuffers > 0)
+        fill = MAX(fill, (gdouble)buffers / maxBuffers);
+    if (maxTime > 0)
+        fill = MAX(fill, (gdouble)time / maxTime);
+
+    return MIN(fill, 1.0);
+}
+
+// Update the displayed values from the latest samples and the queue levels
+void source_stats_refresh(SourceStats *stats, SpsSourceData *sourceData)
+{
+    GHashTableIter iter;
+    gpointer name, value;
+    gint64 now = g_get_monotonic_time();
+    gint fpsStage = -2;
+
+    stats->fps = 0;
+    for (gint i = 0; i < PIPELINE_STAGE_COUNT; i++)
+        stats->stageLatency[i] = 0;
+
+    g_hash_table_iter_init(&iter, stats->samples);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        SourceStatsSample *sample = value;
+        SourceStatsSample *previous = g_hash_table_lookup(stats->previousSamples, name);
+
+        if (now - sample->time > SOURCE_STATS_MAX_AGE)
+        {
+            g_hash_table_remove(stats->previousSamples, name);
+            g_hash_table_iter_remove(&iter);
+            continue;
+        }
+
+        // Elements reset their stats when they restart
+        if (!previous || sample->buffers <= previous->buffers || sample->time <= previous->time)
+            continue;
+
+        guint64 buffers = sample->buffers - previous->buffers;
+        if (sample->stage >= 0 && sample->totalTime >= previous->totalTime)
+            stats->stageLatency[sample->stage] += (sample->totalTime - previous->totalTime) / 1e6 / buffers;
+
+        // The effective frame rate is the one of the last stage that processed frames
+        if (sample->stage >= fpsStage)
+        {
+            gdouble fps = buffers * (gdouble)G_USEC_PER_SEC / (sample->time - previous->time);
+            stats->fps = sample->stage > fpsStage ? fps : MIN(stats->fps, fps);
+            fpsStage = sample->stage;
+        }
+    }
+
+    stats->queueFill[PIPELINE_STAGE_PREPROCESSING] = get_queue_fill(sourceData->preprocessorQueue);
+    stats->queueFill[PIPELINE_STAGE_DETECTION] = get_queue_fill(sourceData->detectorQueue);
+    stats->queueFill[PIPELINE_STAGE_POSTPROCESSING] = get_queue_fill(sourceData->postprocessorQueue);
+}
+
+// Forget all samples, e.g. when the pipeline stops
+void source_stats_reset(SourceStats *stats)
+{
+    g_hash_table_remove_all(stats->samples);
+    g_hash_table_remove_all(stats->previousSamples);
+
+    stats->fps = 0;
+    for (gint i = 0; i < PIPELINE_STAGE_COUNT; i++)
+    {
+        g_atomic_int_set(&stats->leaked[i], 0);
+        stats->stageLatency[i] = 0;
+        stats->queueFill[i] = 0;
+    }
+}
+
+// Single line summary of the last refresh
+gchar *source_stats_to_string(SourceStats *stats)
+{
+    GString *str = g_string_new(NULL);
+
+    for (gint i = 0; i < PIPELINE_STAGE_COUNT; i++)
+    {
+        g_string_append_printf(str, "%s %.1f ms (queue %.0f%%, %d leaked), ",
+                               pipeline_stage_get_name(i), stats->stageLatency[i],
+                               stats->queueFill[i] * 100, g_atomic_int_get(&stats->leaked[i]));
+    }
+    g_string_append_printf(str, "%.1f fps", stats->fps);
+
+    return g_string_free(str, FALSE);
+}
+
+void source_stats_free(SourceStats *stats)
+{
+    g_hash_table_destroy(stats->samples);
+    g_hash_table_destroy(stats->previousSamples);
+    g_free(stats);
+}
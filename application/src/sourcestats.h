@@ -0,0 +1,43 @@
+#pragma once
+
+#include <gst/gst.h>
+#include "sourcedata.h"
+#include "pipelinestats.h"
+
+#define SOURCE_STATS_REFRESH_INTERVAL 1 // Seconds between two updates of the displayed stats
+
+// Latest processing stats an element posted on the bus
+typedef struct _SourceStatsSample SourceStatsSample;
+struct _SourceStatsSample
+{
+    gint stage; // PipelineStage or -1 for the capture source
+    guint64 buffers, totalTime;
+    gint64 time; // Monotonic time the stats were received at in microseconds
+};
+
+// Live view of a source, fed by the stats messages of its elements and the state of its queues
+struct _SourceStats
+{
+    GHashTable *samples, *previousSamples; // Element name -> SourceStatsSample
+
+    gint leaked[PIPELINE_STAGE_COUNT]; // Frames dropped by the leaky queue in front of a stage, updated atomically
+
+    // Values of the last refresh
+    gdouble stageLatency[PIPELINE_STAGE_COUNT]; // Milliseconds per frame
+    gdouble queueFill[PIPELINE_STAGE_COUNT];    // Between 0 and 1
+    gdouble fps;
+};
+
+SourceStats *source_stats_new();
+
+void source_stats_attach(SourceStats *stats, SpsSourceData *sourceData);
+
+gboolean source_stats_handle_message(SourceStats *stats, SpsSourceData *sourceData, GstMessage *msg);
+
+void source_stats_refresh(SourceStats *stats, SpsSourceData *sourceData);
+
+void source_stats_reset(SourceStats *stats);
+
+gchar *source_stats_to_string(SourceStats *stats);
+
+void source_stats_free(SourceStats *stats);
@@ -0,0 +1,375 @@
+#include <glib.h>
+#include <gst/gst.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEFAULT_WIDTH 1920
+#define DEFAULT_HEIGHT 1080
+#define DEFAULT_FPS 30
+#define DEFAULT_FRAMES 300
+#define DEFAULT_CHAIN "changedetector ! regions prefix=bench regions=\"<0:0:640:360,1280:720:640:360>\" ! obstruct labels=\"<bench:region>\""
+
+#define SYNTHETIC_WINDOWS 4
+#define SYNTHETIC_GLYPH_WIDTH 6
+#define SYNTHETIC_GLYPH_HEIGHT 10
+#define SYNTHETIC_TITLE_HEIGHT 24
+#define SYNTHETIC_TYPING_INTERVAL 3 // Frames between two changes of the text in the typing window
+
+typedef struct _SyntheticWindow SyntheticWindow;
+struct _SyntheticWindow
+{
+    gint x, y, width, height;
+    gint dx, dy; // Movement per frame
+    guint32 color;
+};
+
+typedef struct _Benchmark Benchmark;
+struct _Benchmark
+{
+    GMainLoop *loop;
+    GstElement *pipeline, *source;
+    gboolean failed;
+
+    gint width, height, fps, frames;
+    gint pushedFrames;
+
+    // Recorded frames, raw BGRA files of width * height * 4 bytes, played in name order and looped
+    GPtrArray *framePaths;
+
+    // Synthetic desktop
+    SyntheticWindow windows[SYNTHETIC_WINDOWS];
+};
+
+static guint32 hash_glyph(gint window, gint line, gint column, gint seed)
+{
+    guint32 hash = (guint32)(window * 73856093) ^ (guint32)(line * 19349663) ^ (guint32)(column * 83492791) ^ (guint32)(seed * 2654435761u);
+    hash ^= hash >> 13;
+    hash *= 0x5bd1e995;
+
+    return hash ^ (hash >> 15);
+}
+
+static void fill_rect(guint32 *frame, gint width, gint height, gint x, gint y, gint w, gint h, guint32 color)
+{
+    gint x0 = CLAMP(x, 0, width), y0 = CLAMP(y, 0, height);
+    gint x1 = CLAMP(x + w, 0, width), y1 = CLAMP(y + h, 0, height);
+
+    for (gint row = y0; row < y1; row++)
+    {
+        guint32 *line = frame + (gsize)row * width;
+        for (gint col = x0; col < x1; col++)
+            line[col] = color;
+    }
+}
+
+static void synthetic_init(Benchmark *bench)
+{
+    GRand *rand = g_rand_new_with_seed(42);
+
+    for (gint i = 0; i < SYNTHETIC_WINDOWS; i++)
+    {
+        SyntheticWindow *window = &bench->windows[i];
+        window->width = bench->width / 3;
+        window->height = bench->height / 3;
+        window->x = g_rand_int_range(rand, 0, bench->width - window->width);
+        window->y = g_rand_int_range(rand, 0, bench->height - window->height);
+        window->color = 0xff000000 | g_rand_int_range(rand, 0xa0a0a0, 0xffffff);
+
+        // Only the first window moves, the others are static like most of a desktop
+        window->dx = i == 0 ? 7 : 0;
+        window->dy = i == 0 ? 3 : 0;
+    }
+
+    g_rand_free(rand);
+}
+
+// Desktop with overlapping windows full of text. One window moves, another one receives text input.
+static void synthetic_render(Benchmark *bench, guint32 *frame, gint index)
+{
+    fill_rect(frame, bench->width, bench->height, 0, 0, bench->width, bench->height, 0xff3a6ea5);
+
+    for (gint i = 0; i < SYNTHETIC_WINDOWS; i++)
+    {
+        SyntheticWindow *window = &bench->windows[i];
+
+        // Bounce at the screen edges
+        if (window->x + window->dx < 0 || window->x + window->width + window->dx > bench->width)
+            window->dx = -window->dx;
+        if (window->y + window->dy < 0 || window->y + window->height + window->dy > bench->height)
+            window->dy = -window->dy;
+        window->x += window->dx;
+        window->y += window->dy;
+
+        fill_rect(frame, bench->width, bench->height, window->x, window->y, window->width, window->height, window->color);
+        fill_rect(frame, bench->width, bench->height, window->x, window->y, window->width, SYNTHETIC_TITLE_HEIGHT, 0xff202020);
+
+        // Text lines, the typing window changes its content every few frames
+        gint seed = i == 1 ? index / SYNTHETIC_TYPING_INTERVAL : 0;
+        gint lines = (window->height - SYNTHETIC_TITLE_HEIGHT) / (2 * SYNTHETIC_GLYPH_HEIGHT);
+        gint columns = window->width / SYNTHETIC_GLYPH_WIDTH - 2;
+        for (gint line = 0; line < lines; line++)
+        {
+            for (gint column = 0; column < columns; column++)
+            {
+                if (hash_glyph(i, line, column, seed) % 4 == 0)
+                    continue;
+
+                fill_rect(frame, bench->width, bench->height,
+                          window->x + (column + 1) * SYNTHETIC_GLYPH_WIDTH,
+                          window->y + SYNTHETIC_TITLE_HEIGHT + (2 * line + 1) * SYNTHETIC_GLYPH_HEIGHT,
+                          SYNTHETIC_GLYPH_WIDTH - 1, SYNTHETIC_GLYPH_HEIGHT, 0xff000000);
+            }
+        }
+    }
+}
+
+static gint compare_paths(gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0(*(const char **)a, *(const char **)b);
+}
+
+static gboolean recorded_load(Benchmark *bench, const char *directory)
+{
+    GError *error = NULL;
+    GDir *dir = g_dir_open(directory, 0, &error);
+    if (!dir)
+    {
+        g_printerr("Unable to open frame directory: %s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    bench->framePaths = g_ptr_array_new_with_free_func(g_free);
+    const char *name;
+    while ((name = g_dir_read_name(dir)) != NULL)
+        g_ptr_array_add(bench->framePaths, g_build_filename(directory, name, NULL));
+    g_dir_close(dir);
+
+    if (bench->framePaths->len == 0)
+    {
+        g_printerr("Frame directory %s is empty\n", directory);
+        return FALSE;
+    }
+    g_ptr_array_sort(bench->framePaths, compare_paths);
+
+    return TRUE;
+}
+
+static gboolean recorded_render(Benchmark *bench, guint8 *frame, gsize size, gint index)
+{
+    const char *path = g_ptr_array_index(bench->framePaths, index % bench->framePaths->len);
+    gchar *contents = NULL;
+    gsize length;
+
+    if (!g_file_get_contents(path, &contents, &length, NULL) || length != size)
+    {
+        g_printerr("Frame %s is not a raw BGRA frame of %ix%i\n", path, bench->width, bench->height);
+        g_free(contents);
+        return FALSE;
+    }
+    memcpy(frame, contents, size);
+    g_free(contents);
+
+    return TRUE;
+}
+
+static void cb_need_data(GstElement *source, guint length, Benchmark *bench)
+{
+    GstFlowReturn ret;
+
+    if (bench->pushedFrames >= bench->frames)
+    {
+        g_signal_emit_by_name(source, "end-of-stream", &ret);
+        return;
+    }
+
+    gsize size = (gsize)bench->width * bench->height * 4;
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, size, NULL);
+    GstMapInfo map;
+    gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+
+    gboolean success = TRUE;
+    if (bench->framePaths)
+        success = recorded_render(bench, map.data, size, bench->pushedFrames);
+    else
+        synthetic_render(bench, (guint32 *)map.data, bench->pushedFrames);
+    gst_buffer_unmap(buffer, &map);
+
+    if (!success)
+    {
+        gst_buffer_unref(buffer);
+        bench->failed = TRUE;
+        g_signal_emit_by_name(source, "end-of-stream", &ret);
+        return;
+    }
+
+    // Timestamps follow the nominal frame rate, no matter how fast frames are processed
+    GST_BUFFER_PTS(buffer) = gst_util_uint64_scale_int(bench->pushedFrames, GST_SECOND, bench->fps);
+    GST_BUFFER_DURATION(buffer) = gst_util_uint64_scale_int(1, GST_SECOND, bench->fps);
+    bench->pushedFrames++;
+
+    g_signal_emit_by_name(source, "push-buffer", buffer, &ret);
+    gst_buffer_unref(buffer);
+}
+
+static gboolean cb_bus_message(GstBus *bus, GstMessage *msg, Benchmark *bench)
+{
+    switch (GST_MESSAGE_TYPE(msg))
+    {
+    case GST_MESSAGE_ERROR:
+    {
+        GError *error;
+        gchar *debug;
+        gst_message_parse_error(msg, &error, &debug);
+        g_printerr("Error from %s: %s\n%s\n", GST_OBJECT_NAME(GST_MESSAGE_SRC(msg)), error->message, debug ? debug : "");
+        g_error_free(error);
+        g_free(debug);
+
+        bench->failed = TRUE;
+        g_main_loop_quit(bench->loop);
+    }
+    break;
+    case GST_MESSAGE_EOS:
+        g_main_loop_quit(bench->loop);
+        break;
+    default:
+        break;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void print_element_stats(const GValue *item, gpointer userData)
+{
+    GstElement *element = g_value_get_object(item);
+    GParamSpec *pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(element), "stats");
+    if (!pspec || G_PARAM_SPEC_VALUE_TYPE(pspec) != GST_TYPE_STRUCTURE)
+        return;
+
+    GstStructure *stats;
+    g_object_get(element, "stats", &stats, NULL);
+    if (!stats)
+        return;
+
+    guint64 buffers = 0, dropped = 0, inferences = 0, skipped = 0, total = 0, mean = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+    gst_structure_get(stats,
+                      "buffers", G_TYPE_UINT64, &buffers, "dropped", G_TYPE_UINT64, &dropped,
+                      "inferences", G_TYPE_UINT64, &inferences, "skipped", G_TYPE_UINT64, &skipped,
+                      "total", G_TYPE_UINT64, &total, "mean", G_TYPE_UINT64, &mean,
+                      "p50", G_TYPE_UINT64, &p50, "p95", G_TYPE_UINT64, &p95, "p99", G_TYPE_UINT64, &p99,
+                      "max", G_TYPE_UINT64, &max, NULL);
+    gst_structure_free(stats);
+
+    // Throughput is the frame rate the element could sustain on its own
+    gdouble fps = total > 0 ? buffers * (gdouble)GST_SECOND / total : 0;
+    printf("%s,%s,%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%.2f,%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT "\n",
+           GST_OBJECT_NAME(element), GST_OBJECT_NAME(gst_element_get_factory(element)),
+           buffers, dropped, inferences, skipped, fps, mean, p50, p95, p99, max);
+}
+
+// Runs a chain of elements on recorded or synthetic desktop frames as fast as possible.
+// Prints one CSV line per element reporting processing stats and one for the whole chain.
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    Benchmark bench = {
+        .width = DEFAULT_WIDTH,
+        .height = DEFAULT_HEIGHT,
+        .fps = DEFAULT_FPS,
+        .frames = DEFAULT_FRAMES,
+    };
+    const char *chain = NULL, *frameDir = NULL, *gstElementsPath = NULL;
+    GOptionContext *context = g_option_context_new("- benchmark a chain of processing elements");
+    GError *error = NULL;
+    GOptionEntry entries[] =
+    {
+        { "chain", 'c', 0, G_OPTION_ARG_STRING, &chain, "Elements to benchmark in gst-launch syntax (default: " DEFAULT_CHAIN ")", "description" },
+        { "frame-dir", 'd', 0, G_OPTION_ARG_FILENAME, &frameDir, "Directory of raw BGRA frames used instead of a synthetic desktop", "directory" },
+        { "gst-elements", 'g', 0, G_OPTION_ARG_STRING, &gstElementsPath, "Path to GStreamer elements", "gstreamer-elements-path" },
+        { "frames", 'n', 0, G_OPTION_ARG_INT, &bench.frames, "Number of frames to process", "count" },
+        { "width", 'W', 0, G_OPTION_ARG_INT, &bench.width, "Frame width", "pixels" },
+        { "height", 'H', 0, G_OPTION_ARG_INT, &bench.height, "Frame height", "pixels" },
+        { "fps", 'f', 0, G_OPTION_ARG_INT, &bench.fps, "Nominal frame rate of the timestamps", "fps" },
+        { NULL }
+    };
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error))
+    {
+        g_printerr("Option parsing failed: %s\n", error->message);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    if (bench.width <= 0 || bench.height <= 0 || bench.fps <= 0 || bench.frames <= 0)
+    {
+        g_printerr("Frame size, rate and count have to be positive\n");
+        return 1;
+    }
+
+    if (gstElementsPath)
+        gst_registry_scan_path(gst_registry_get(), gstElementsPath);
+
+    if (frameDir)
+    {
+        if (!recorded_load(&bench, frameDir))
+            return 1;
+    }
+    else
+        synthetic_init(&bench);
+
+    // Build pipeline around the chain
+    gchar *description = g_strdup_printf("appsrc name=source format=time caps=\"video/x-raw,format=BGRA,width=%i,height=%i,framerate=%i/1\" ! %s ! fakesink sync=false",
+                                         bench.width, bench.height, bench.fps, chain ? chain : DEFAULT_CHAIN);
+    bench.pipeline = gst_parse_launch(description, &error);
+    g_free(description);
+    if (!bench.pipeline)
+    {
+        g_printerr("Unable to create pipeline: %s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+
+    // Without a clock, nothing waits for the nominal frame rate and the chain runs at full speed
+    gst_pipeline_use_clock(GST_PIPELINE(bench.pipeline), NULL);
+
+    bench.source = gst_bin_get_by_name(GST_BIN(bench.pipeline), "source");
+    g_signal_connect(bench.source, "need-data", G_CALLBACK(cb_need_data), &bench);
+
+    bench.loop = g_main_loop_new(NULL, FALSE);
+    GstBus *bus = gst_element_get_bus(bench.pipeline);
+    gst_bus_add_watch(bus, (GstBusFunc)cb_bus_message, &bench);
+    gst_object_unref(bus);
+
+    gint64 start = g_get_monotonic_time();
+    if (gst_element_set_state(bench.pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    {
+        g_printerr("Unable to start pipeline\n");
+        bench.failed = TRUE;
+    }
+    else
+        g_main_loop_run(bench.loop);
+    gint64 elapsed = g_get_monotonic_time() - start; // Microseconds
+
+    printf("element,factory,buffers,dropped,inferences,skipped,fps,mean_ns,p50_ns,p95_ns,p99_ns,max_ns\n");
+    GstIterator *iter = gst_bin_iterate_recurse(GST_BIN(bench.pipeline));
+    gst_iterator_foreach(iter, print_element_stats, NULL);
+    gst_iterator_free(iter);
+
+    // Whole chain, including conversions and queues between the measured elements
+    guint64 frameTime = elapsed > 0 && bench.pushedFrames > 0 ? elapsed * 1000 / bench.pushedFrames : 0;
+    printf("pipeline,pipeline,%i,0,0,0,%.2f,%" G_GUINT64_FORMAT ",,,,\n",
+           bench.pushedFrames, elapsed > 0 ? bench.pushedFrames * (gdouble)G_USEC_PER_SEC / elapsed : 0, frameTime);
+
+    gst_element_set_state(bench.pipeline, GST_STATE_NULL);
+    gst_object_unref(bench.source);
+    gst_object_unref(bench.pipeline);
+    g_main_loop_unref(bench.loop);
+    if (bench.framePaths)
+        g_ptr_array_free(bench.framePaths, TRUE);
+    g_free((void *)chain);
+    g_free((void *)frameDir);
+    g_free((void *)gstElementsPath);
+
+    return bench.failed ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+#include <glib.h>
+#include <stdio.h>
+#include <privacyfilter.h>
+
+#define FRAME_WIDTH 3840
+#define FRAME_HEIGHT 2160
+#define DEFAULT_ITERATIONS 20
+#define DEFAULT_STRENGTH 64
+
+// Measures the blur and pixelate filters on square regions of increasing size within a 4K BGRA frame.
+// Prints one CSV line per filter and region size.
+int main(int argc, char *argv[])
+{
+    gint iterations = DEFAULT_ITERATIONS, strength = DEFAULT_STRENGTH;
+    GOptionContext *context = g_option_context_new("- benchmark the obstruct privacy filters");
+    GError *error = NULL;
+    GOptionEntry entries[] =
+    {
+        { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations, "Iterations per measurement", "count" },
+        { "strength", 's', 0, G_OPTION_ARG_INT, &strength, "Blur radius resp. pixelation block size", "pixels" },
+        { NULL }
+    };
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error))
+    {
+        g_printerr("Option parsing failed: %s\n", error->message);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    // Fill frame with noise so that no filter can take shortcuts
+    gsize stride = FRAME_WIDTH * PRIVACY_FILTER_CHANNELS;
+    guint8 *frame = g_malloc(stride * FRAME_HEIGHT);
+    GRand *rand = g_rand_new_with_seed(42);
+    for (gsize i = 0; i < stride * FRAME_HEIGHT; i++)
+        frame[i] = (guint8)g_rand_int_range(rand, 0, 256);
+    g_rand_free(rand);
+
+    const gint sizes[] = {64, 128, 256, 512, 1024, 2048, FRAME_HEIGHT};
+    const char *filters[] = {"box", "gaussian", "pixelate"};
+
+    printf("filter,size,strength,ms_per_region,ns_per_pixel\n");
+    for (guint f = 0; f < G_N_ELEMENTS(filters); f++)
+    {
+        for (guint s = 0; s < G_N_ELEMENTS(sizes); s++)
+        {
+            BoundingBox region = {
+                .x = 0,
+                .y = 0,
+                .width = sizes[s],
+                .height = sizes[s],
+            };
+
+            gint64 start = g_get_monotonic_time();
+            for (gint i = 0; i < iterations; i++)
+            {
+                switch (f)
+                {
+                case 0:
+                    privacy_filter_box_blur(frame, stride, &region, strength, 1);
+                    break;
+                case 1:
+                    privacy_filter_box_blur(frame, stride, &region, strength, PRIVACY_FILTER_GAUSSIAN_PASSES);
+                    break;
+                default:
+                    privacy_filter_pixelate(frame, stride, &region, strength);
+                    break;
+                }
+            }
+            gint64 elapsed = g_get_monotonic_time() - start; // Microseconds
+
+            gdouble msPerRegion = elapsed / 1000.0 / iterations;
+            gdouble nsPerPixel = elapsed * 1000.0 / iterations / ((gdouble)region.width * region.height);
+            printf("%s,%i,%i,%.3f,%.3f\n", filters[f], sizes[s], strength, msPerRegion, nsPerPixel);
+        }
+    }
+
+    g_free(frame);
+
+    return 0;
+}
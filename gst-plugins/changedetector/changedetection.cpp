@@ -10,7 +10,7 @@
 
 using namespace cv;
 
-static void add_metadata(GstChangeDetector *filter, GstBuffer *buffer, gboolean changed, GArray *regions = NULL)
+static void add_metadata(GstChangeDetector *filter, GstBuffer *buffer, GstBuffer *referenceBuffer, gboolean changed, GArray *regions = NULL)
 {
     GstChangeMeta *changeMeta;
 
@@ -19,6 +19,7 @@ static void add_metadata(GstChangeDetector *filter, GstBuffer *buffer, gboolean
 
     changeMeta = GST_CHANGE_META_ADD(buffer);
     changeMeta->changed = changed;
+    changeMeta->referencePts = referenceBuffer ? GST_BUFFER_PTS(referenceBuffer) : GST_CLOCK_TIME_NONE;
     GST_DEBUG_OBJECT(filter, "Adding change meta to buffer %p. Changed: %i", buffer, changed);
 
     if (!regions)
@@ -55,7 +56,7 @@ void detect_changes(GstChangeDetector *filter, GstBuffer *currentBuffer, GstBuff
             .height = (int)videoMetaCurrent->height,
         };
         g_array_append_val(regions, fullScreen);
-        add_metadata(filter, currentBuffer, TRUE, regions);
+        add_metadata(filter, currentBuffer, NULL, TRUE, regions);
         return;
     }
 
@@ -78,7 +79,7 @@ void detect_changes(GstChangeDetector *filter, GstBuffer *currentBuffer, GstBuff
             .height = (int)videoMetaCurrent->height,
         };
         g_array_append_val(regions, fullScreen);
-        add_metadata(filter, currentBuffer, TRUE, regions);
+        add_metadata(filter, currentBuffer, lastBuffer, TRUE, regions);
         return;
     }
 
@@ -115,7 +116,7 @@ void detect_changes(GstChangeDetector *filter, GstBuffer *currentBuffer, GstBuff
     // No change detected. Return instantly
     if (changedPixelRatio <= filter->threshold)
     {
-        add_metadata(filter, currentBuffer, FALSE);
+        add_metadata(filter, currentBuffer, lastBuffer, FALSE);
         return;
     }
 
@@ -149,7 +150,7 @@ void detect_changes(GstChangeDetector *filter, GstBuffer *currentBuffer, GstBuff
         g_array_append_val(regions, bbox);
     }
 
-    add_metadata(filter, currentBuffer, TRUE, regions);
+    add_metadata(filter, currentBuffer, lastBuffer, TRUE, regions);
 out:
     return;
 }
\ No newline at end of file
@@ -30,6 +30,7 @@ enum
     PROP_0,
     PROP_ACTIVE,
     PROP_THRESHOLD,
+    PROP_STATS,
 };
 
 // TODO: Possibly allow more formats in the future
@@ -72,6 +73,9 @@ static void gst_change_detector_get_property(GObject *object, guint prop_id, GVa
     case PROP_ACTIVE:
         g_value_set_boolean(value, filter->active);
         break;
+    case PROP_STATS:
+        g_value_take_boxed(value, gst_processing_stats_get_structure(filter->stats));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -79,14 +83,21 @@ static void gst_change_detector_get_property(GObject *object, guint prop_id, GVa
 }
 
 // Prepare to start proceassing -> open ressources, etc.
-static gboolean gst_change_detector_start(GstChangeDetector *filter)
+static gboolean gst_change_detector_start(GstBaseTransform *parent)
 {
+    GstChangeDetector *filter = GST_CHANGE_DETECTOR(parent);
+
+    gst_processing_stats_reset(filter->stats);
+    gst_qos_tracker_reset(filter->qos);
+
     return TRUE;
 }
 
 // Stop processing -> free ressources
-static gboolean gst_change_detector_stop(GstChangeDetector *filter)
+static gboolean gst_change_detector_stop(GstBaseTransform *parent)
 {
+    GstChangeDetector *filter = GST_CHANGE_DETECTOR(parent);
+
     if (filter->lastBuffer)
         gst_buffer_unref(filter->lastBuffer);
 
@@ -146,14 +157,36 @@ static gboolean gst_change_detector_query(GstBaseTransform *parent, GstPadDirect
     return GST_BASE_TRANSFORM_CLASS(parent_class)->query(parent, direction, query);
 }
 
+// Handle events travelling upstream
+static gboolean gst_change_detector_src_event(GstBaseTransform *base, GstEvent *event)
+{
+    GstChangeDetector *filter = GST_CHANGE_DETECTOR(base);
+
+    if (GST_EVENT_TYPE(event) == GST_EVENT_QOS)
+        gst_qos_tracker_update(filter->qos, event);
+
+    return GST_BASE_TRANSFORM_CLASS(parent_class)->src_event(base, event);
+}
+
 // Handle incoming buffer
 static GstFlowReturn gst_change_detector_transform_buffer(GstBaseTransform *base, GstBuffer *buffer)
 {
     GstChangeDetector *filter = GST_CHANGE_DETECTOR(base);
     GstFlowReturn ret = GST_FLOW_OK;
+    GstClockTime begin = gst_processing_stats_begin();
 
     GST_DEBUG_OBJECT(filter, "Received buffer %p", buffer);
 
+    // Drop buffers downstream reported to be too late for, changes are then detected against the last processed frame
+    GstClockTime runningTime = gst_segment_to_running_time(&base->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+    if (gst_qos_tracker_is_late(filter->qos, runningTime))
+    {
+        GST_DEBUG_OBJECT(filter, "Buffer is late, dropping it");
+        gst_processing_stats_add_dropped(filter->stats);
+        ret = GST_BASE_TRANSFORM_FLOW_DROPPED;
+        goto out;
+    }
+
     if (!filter->active)
     {
         GST_DEBUG_OBJECT(filter, "Filter disabled, no processing");
@@ -171,6 +204,7 @@ static GstFlowReturn gst_change_detector_transform_buffer(GstBaseTransform *base
     filter->lastBuffer = gst_buffer_ref(buffer);
 
 out:
+    gst_processing_stats_end(filter->stats, begin);
     return ret;
 }
 
@@ -181,6 +215,9 @@ static void gst_change_detector_init(GstChangeDetector *filter)
     filter->threshold = 0;
     filter->active = TRUE;
     filter->lastBuffer = NULL;
+
+    filter->stats = gst_processing_stats_new(GST_ELEMENT(filter));
+    filter->qos = gst_qos_tracker_new();
 }
 
 // Object destructor -> called if an object gets destroyed
@@ -188,6 +225,9 @@ static void gst_change_detector_finalize(GObject *object)
 {
     GstChangeDetector *filter = GST_CHANGE_DETECTOR(object);
 
+    gst_processing_stats_free(filter->stats);
+    gst_qos_tracker_free(filter->qos);
+
     G_OBJECT_CLASS(gst_change_detector_parent_class)->finalize(object);
 }
 
@@ -219,6 +259,8 @@ static void gst_change_detector_class_init(GstChangeDetectorClass *klass)
                                                      0, 100, 0,
                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+    g_object_class_install_property(gobject_class, PROP_STATS, gst_processing_stats_param_spec());
+
     // Set plugin metadata
     gst_element_class_set_static_metadata(gstelement_class,
                                           "Change detector filter", "Filter/Video",
@@ -233,6 +275,9 @@ static void gst_change_detector_class_init(GstChangeDetectorClass *klass)
     // Set function pointers to implementation of base class
     gstbasetransform_class->transform_ip = GST_DEBUG_FUNCPTR(gst_change_detector_transform_buffer);
     gstbasetransform_class->query = GST_DEBUG_FUNCPTR(gst_change_detector_query);
+    gstbasetransform_class->src_event = GST_DEBUG_FUNCPTR(gst_change_detector_src_event);
+    gstbasetransform_class->start = GST_DEBUG_FUNCPTR(gst_change_detector_start);
+    gstbasetransform_class->stop = GST_DEBUG_FUNCPTR(gst_change_detector_stop);
 }
 
 // Plugin initializer that registers the plugin
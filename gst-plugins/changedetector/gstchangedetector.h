@@ -2,6 +2,8 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <processingstats.h>
+#include <qostracker.h>
 
 G_BEGIN_DECLS
 
@@ -24,6 +26,9 @@ struct _GstChangeDetector
   
   float threshold;
   gboolean active;
+
+  GstProcessingStats *stats;
+  GstQosTracker *qos;
 };
 
 struct _GstChangeDetectorClass
@@ -24,6 +24,7 @@ static gboolean gst_change_meta_init(GstMeta *basemeta, gpointer params, GstBuff
 
     meta->changed = FALSE;
     meta->regions = g_array_new(FALSE, FALSE, sizeof(BoundingBox));
+    meta->referencePts = GST_CLOCK_TIME_NONE;
 
     return TRUE;
 }
@@ -55,6 +56,7 @@ static gboolean gst_change_meta_transform(GstBuffer *dest, GstMeta *meta, GstBuf
         newMeta->changed = oldMeta->changed;
         g_array_free(newMeta->regions, TRUE);
         newMeta->regions = g_array_copy(oldMeta->regions);
+        newMeta->referencePts = oldMeta->referencePts;
 
         return TRUE;
     }
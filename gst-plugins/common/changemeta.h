@@ -17,7 +17,8 @@ struct _GstChangeMeta
     GstMeta meta;
 
     gboolean changed;
-    GArray *regions; // Array of bounding boxes
+    GArray *regions;           // Array of bounding boxes
+    GstClockTime referencePts; // PTS of the frame the changes are relative to
 };
 
 GType gst_change_meta_api_get_type(void);
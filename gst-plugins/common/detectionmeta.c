@@ -265,3 +265,33 @@ GArray *gst_bounding_box_subtract_from_boxes(GArray *inRects, BoundingBox *subtr
 
     return outRects;
 }
+
+// Converts a set of possibly overlapping bounding boxes into a set of disjoint boxes covering the same area
+GArray *gst_bounding_box_make_disjoint(GArray *inRects)
+{
+    GArray *outRects = g_array_new(FALSE, FALSE, sizeof(BoundingBox));
+
+    for (gint i = 0; i < inRects->len; i++)
+    {
+        BoundingBox *rect = &g_array_index(inRects, BoundingBox, i);
+        if (rect->width <= 0 || rect->height <= 0)
+            continue;
+
+        // Remove every part that is already covered by a previous box
+        GArray *pieces = g_array_new(FALSE, FALSE, sizeof(BoundingBox));
+        g_array_append_vals(pieces, rect, 1);
+        for (gint j = 0; j < outRects->len && pieces->len > 0; j++)
+        {
+            BoundingBox *covered = &g_array_index(outRects, BoundingBox, j);
+
+            GArray *remaining = gst_bounding_box_subtract_from_boxes(pieces, covered);
+            g_array_free(pieces, TRUE);
+            pieces = remaining;
+        }
+
+        g_array_append_vals(outRects, pieces->data, pieces->len);
+        g_array_free(pieces, TRUE);
+    }
+
+    return outRects;
+}
@@ -59,5 +59,6 @@ BoundingBox gst_bounding_box_intersect(BoundingBox *b1, BoundingBox *b2);
 gboolean gst_bounding_box_contains(BoundingBox *box, BoundingBox *test);
 GArray *gst_bounding_box_subtract_from_box(BoundingBox *rect, BoundingBox *subtract);
 GArray *gst_bounding_box_subtract_from_boxes(GArray *inRects, BoundingBox *subtract);
+GArray *gst_bounding_box_make_disjoint(GArray *inRects);
 
 G_END_DECLS
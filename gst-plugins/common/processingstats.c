@@ -0,0 +1,186 @@
+#include "processingstats.h"
+#include <string.h>
+
+// Logarithmic histogram with 8 buckets per power of two, values below 8ns are exact
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+struct _GstProcessingStats
+{
+    GstElement *element; // Not referenced, the stats are owned by the element
+
+    GMutex mtxStats;
+    guint64 histogram[HISTOGRAM_BUCKETS];
+    guint64 buffers, dropped, inferences, skipped;
+    GstClockTime totalTime, maxTime;
+    GstClockTime lastPost;
+};
+
+static guint most_significant_bit(guint64 value)
+{
+    guint msb = 0;
+    while (value >>= 1)
+        msb++;
+
+    return msb;
+}
+
+static guint bucket_index(guint64 value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS)
+        return value;
+
+    guint msb = most_significant_bit(value);
+    guint sub = (value >> (msb - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1);
+
+    return (msb - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Center of the value range covered by a bucket
+static guint64 bucket_value(guint index)
+{
+    if (index < HISTOGRAM_SUB_BUCKETS)
+        return index;
+
+    guint shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    guint sub = index % HISTOGRAM_SUB_BUCKETS;
+    guint64 lower = (guint64)(HISTOGRAM_SUB_BUCKETS + sub) << shift;
+
+    return lower + ((1ull << shift) >> 1);
+}
+
+// Must be called with the stats locked
+static GstClockTime get_percentile(GstProcessingStats *stats, gdouble percentile)
+{
+    if (stats->buffers == 0)
+        return 0;
+
+    guint64 target = MAX((guint64)(percentile * stats->buffers + 0.5), 1);
+    guint64 count = 0;
+    for (guint i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        count += stats->histogram[i];
+        if (count >= target)
+            return MIN(bucket_value(i), stats->maxTime);
+    }
+
+    return stats->maxTime;
+}
+
+// Must be called with the stats locked
+static GstStructure *create_structure(GstProcessingStats *stats)
+{
+    return gst_structure_new(GST_PROCESSING_STATS_NAME,
+                             "element", G_TYPE_STRING, GST_OBJECT_NAME(stats->element),
+                             "buffers", G_TYPE_UINT64, stats->buffers,
+                             "dropped", G_TYPE_UINT64, stats->dropped,
+                             "inferences", G_TYPE_UINT64, stats->inferences,
+                             "skipped", G_TYPE_UINT64, stats->skipped,
+                             "total", G_TYPE_UINT64, stats->totalTime,
+                             "mean", G_TYPE_UINT64, stats->buffers ? stats->totalTime / stats->buffers : 0,
+                             "p50", G_TYPE_UINT64, get_percentile(stats, 0.50),
+                             "p95", G_TYPE_UINT64, get_percentile(stats, 0.95),
+                             "p99", G_TYPE_UINT64, get_percentile(stats, 0.99),
+                             "max", G_TYPE_UINT64, stats->maxTime,
+                             NULL);
+}
+
+GstProcessingStats *gst_processing_stats_new(GstElement *element)
+{
+    GstProcessingStats *stats = g_new0(GstProcessingStats, 1);
+    stats->element = element;
+    g_mutex_init(&stats->mtxStats);
+    stats->lastPost = GST_CLOCK_TIME_NONE;
+
+    return stats;
+}
+
+void gst_processing_stats_free(GstProcessingStats *stats)
+{
+    g_mutex_clear(&stats->mtxStats);
+    g_free(stats);
+}
+
+// Clear all recorded values, e.g. when the element (re)starts processing
+void gst_processing_stats_reset(GstProcessingStats *stats)
+{
+    g_mutex_lock(&stats->mtxStats);
+    memset(stats->histogram, 0, sizeof(stats->histogram));
+    stats->buffers = stats->dropped = stats->inferences = stats->skipped = 0;
+    stats->totalTime = stats->maxTime = 0;
+    stats->lastPost = GST_CLOCK_TIME_NONE;
+    g_mutex_unlock(&stats->mtxStats);
+}
+
+// Timestamp at the beginning of the processing of a buffer
+GstClockTime gst_processing_stats_begin()
+{
+    return gst_util_get_timestamp();
+}
+
+// Record the processing time of a buffer, posts the stats on the bus from time to time
+void gst_processing_stats_end(GstProcessingStats *stats, GstClockTime begin)
+{
+    GstClockTime now = gst_util_get_timestamp();
+    GstClockTime duration = now - begin;
+    GstStructure *structure = NULL;
+
+    g_mutex_lock(&stats->mtxStats);
+    stats->histogram[bucket_index(duration)]++;
+    stats->buffers++;
+    stats->totalTime += duration;
+    stats->maxTime = MAX(stats->maxTime, duration);
+
+    if (!GST_CLOCK_TIME_IS_VALID(stats->lastPost))
+        stats->lastPost = now;
+    else if (now - stats->lastPost >= GST_PROCESSING_STATS_INTERVAL)
+    {
+        structure = create_structure(stats);
+        stats->lastPost = now;
+    }
+    g_mutex_unlock(&stats->mtxStats);
+
+    if (structure)
+        gst_element_post_message(stats->element, gst_message_new_element(GST_OBJECT(stats->element), structure));
+}
+
+void gst_processing_stats_add_dropped(GstProcessingStats *stats)
+{
+    g_mutex_lock(&stats->mtxStats);
+    stats->dropped++;
+    g_mutex_unlock(&stats->mtxStats);
+}
+
+void gst_processing_stats_add_inference(GstProcessingStats *stats)
+{
+    g_mutex_lock(&stats->mtxStats);
+    stats->inferences++;
+    g_mutex_unlock(&stats->mtxStats);
+}
+
+void gst_processing_stats_add_skipped(GstProcessingStats *stats)
+{
+    g_mutex_lock(&stats->mtxStats);
+    stats->skipped++;
+    g_mutex_unlock(&stats->mtxStats);
+}
+
+// Snapshot of the current stats, owned by the caller
+GstStructure *gst_processing_stats_get_structure(GstProcessingStats *stats)
+{
+    g_mutex_lock(&stats->mtxStats);
+    GstStructure *structure = create_structure(stats);
+    g_mutex_unlock(&stats->mtxStats);
+
+    return structure;
+}
+
+// Spec of the read-only stats property every instrumented element installs
+GParamSpec *gst_processing_stats_param_spec()
+{
+    return g_param_spec_boxed("stats", "Statistics",
+                              "Processing time percentiles (ns), dropped buffers and inference counts",
+                              GST_TYPE_STRUCTURE,
+                              G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_PROCESSING_STATS_NAME "sps-processing-stats" // Name of the stats structure and the element messages carrying it
+#define GST_PROCESSING_STATS_INTERVAL GST_SECOND          // Time between two stats messages on the bus
+
+/**
+ * GstProcessingStats:
+ *
+ * Per element processing statistics. Records how long an element spends on each buffer,
+ * how many buffers it dropped and how often it ran or skipped its inference.
+ */
+typedef struct _GstProcessingStats GstProcessingStats;
+
+GstProcessingStats *gst_processing_stats_new(GstElement *element);
+void gst_processing_stats_free(GstProcessingStats *stats);
+void gst_processing_stats_reset(GstProcessingStats *stats);
+
+GstClockTime gst_processing_stats_begin();
+void gst_processing_stats_end(GstProcessingStats *stats, GstClockTime begin);
+void gst_processing_stats_add_dropped(GstProcessingStats *stats);
+void gst_processing_stats_add_inference(GstProcessingStats *stats);
+void gst_processing_stats_add_skipped(GstProcessingStats *stats);
+
+GstStructure *gst_processing_stats_get_structure(GstProcessingStats *stats);
+GParamSpec *gst_processing_stats_param_spec();
+
+G_END_DECLS
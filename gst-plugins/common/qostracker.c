@@ -0,0 +1,79 @@
+#include "qostracker.h"
+
+struct _GstQosTracker
+{
+    GMutex mtxQos; // QoS events arrive on another thread than the buffers
+    gdouble proportion;
+    GstClockTime earliestTime;
+};
+
+GstQosTracker *gst_qos_tracker_new()
+{
+    GstQosTracker *tracker = g_new0(GstQosTracker, 1);
+    g_mutex_init(&tracker->mtxQos);
+    tracker->proportion = 1.0;
+    tracker->earliestTime = GST_CLOCK_TIME_NONE;
+
+    return tracker;
+}
+
+void gst_qos_tracker_free(GstQosTracker *tracker)
+{
+    g_mutex_clear(&tracker->mtxQos);
+    g_free(tracker);
+}
+
+// Forget the last report, e.g. when the element (re)starts or flushes
+void gst_qos_tracker_reset(GstQosTracker *tracker)
+{
+    g_mutex_lock(&tracker->mtxQos);
+    tracker->proportion = 1.0;
+    tracker->earliestTime = GST_CLOCK_TIME_NONE;
+    g_mutex_unlock(&tracker->mtxQos);
+}
+
+// Take over a QoS event travelling upstream, the event itself is not modified
+void gst_qos_tracker_update(GstQosTracker *tracker, GstEvent *event)
+{
+    gdouble proportion;
+    GstClockTimeDiff diff;
+    GstClockTime timestamp;
+
+    g_return_if_fail(GST_EVENT_TYPE(event) == GST_EVENT_QOS);
+    gst_event_parse_qos(event, NULL, &proportion, &diff, &timestamp);
+
+    g_mutex_lock(&tracker->mtxQos);
+    tracker->proportion = proportion;
+    if (GST_CLOCK_TIME_IS_VALID(timestamp))
+    {
+        // Like GstBaseTransform: when late, expect to stay late for twice the observed lateness
+        if (diff > 0)
+            tracker->earliestTime = timestamp + 2 * diff;
+        else
+            tracker->earliestTime = timestamp + diff;
+    }
+    g_mutex_unlock(&tracker->mtxQos);
+}
+
+// Whether a buffer with the given running time is expected to be late at the sink
+gboolean gst_qos_tracker_is_late(GstQosTracker *tracker, GstClockTime runningTime)
+{
+    if (!GST_CLOCK_TIME_IS_VALID(runningTime))
+        return FALSE;
+
+    g_mutex_lock(&tracker->mtxQos);
+    gboolean late = GST_CLOCK_TIME_IS_VALID(tracker->earliestTime) && runningTime <= tracker->earliestTime;
+    g_mutex_unlock(&tracker->mtxQos);
+
+    return late;
+}
+
+// Ratio of the processing rate downstream needs and the one it achieves, larger than 1 if it falls behind
+gdouble gst_qos_tracker_get_proportion(GstQosTracker *tracker)
+{
+    g_mutex_lock(&tracker->mtxQos);
+    gdouble proportion = tracker->proportion;
+    g_mutex_unlock(&tracker->mtxQos);
+
+    return proportion;
+}
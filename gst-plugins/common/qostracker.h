@@ -0,0 +1,23 @@
+#pragma once
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstQosTracker:
+ *
+ * Keeps the latest QoS report of downstream, so elements can skip or degrade the processing
+ * of buffers that would arrive too late anyway.
+ */
+typedef struct _GstQosTracker GstQosTracker;
+
+GstQosTracker *gst_qos_tracker_new();
+void gst_qos_tracker_free(GstQosTracker *tracker);
+void gst_qos_tracker_reset(GstQosTracker *tracker);
+
+void gst_qos_tracker_update(GstQosTracker *tracker, GstEvent *event);
+gboolean gst_qos_tracker_is_late(GstQosTracker *tracker, GstClockTime runningTime);
+gdouble gst_qos_tracker_get_proportion(GstQosTracker *tracker);
+
+G_END_DECLS
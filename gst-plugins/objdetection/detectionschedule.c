@@ -0,0 +1,205 @@
+#include "detectionschedule.h"
+#include <detectionmeta.h>
+
+typedef struct _ScheduleEntry ScheduleEntry;
+struct _ScheduleEntry
+{
+    GstClockTime pts;
+    GPtrArray *detections;
+};
+
+G_DEFINE_TYPE(GstDetectionSchedule, gst_detection_schedule, G_TYPE_OBJECT);
+
+static void schedule_entry_clear(ScheduleEntry *entry)
+{
+    g_ptr_array_unref(entry->detections);
+}
+
+// Index of the first entry with a timestamp larger than pts
+static guint upper_bound(GArray *entries, GstClockTime pts)
+{
+    guint low = 0, high = entries->len;
+    while (low < high)
+    {
+        guint mid = (low + high) / 2;
+        if (g_array_index(entries, ScheduleEntry, mid).pts <= pts)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+static gfloat iou(BoundingBox *a, BoundingBox *b)
+{
+    if (!gst_bounding_box_do_intersect(a, b))
+        return 0;
+
+    BoundingBox intersection = gst_bounding_box_intersect(a, b);
+    gfloat intersectionArea = (gfloat)intersection.width * intersection.height;
+    gfloat unionArea = (gfloat)a->width * a->height + (gfloat)b->width * b->height - intersectionArea;
+
+    return unionArea > 0 ? intersectionArea / unionArea : 0;
+}
+
+static gint interpolate(gint a, gint b, gdouble factor)
+{
+    return a + (gint)((b - a) * factor);
+}
+
+// Interpolate between two keyframes. Fails if detections appear, disappear or jump between them.
+static GPtrArray *interpolate_detections(GPtrArray *first, GPtrArray *second, gdouble factor, gfloat minIou)
+{
+    if (first->len != second->len)
+        return NULL;
+
+    GPtrArray *result = g_ptr_array_new_with_free_func(g_object_unref);
+    gboolean *used = g_new0(gboolean, second->len);
+
+    for (guint i = 0; i < first->len; i++)
+    {
+        GstDetection *a = g_ptr_array_index(first, i);
+
+        // Find best matching detection of the same class
+        gint match = -1;
+        gfloat bestIou = minIou;
+        for (guint j = 0; j < second->len; j++)
+        {
+            GstDetection *b = g_ptr_array_index(second, j);
+            if (used[j] || g_strcmp0(a->label, b->label) != 0)
+                continue;
+
+            gfloat score = iou(&a->bbox, &b->bbox);
+            if (score >= bestIou)
+            {
+                bestIou = score;
+                match = j;
+            }
+        }
+
+        if (match < 0)
+        {
+            g_ptr_array_unref(result);
+            result = NULL;
+            break;
+        }
+        used[match] = TRUE;
+
+        // Move the box linearly and grow it by half of the movement, covering objects not moving linearly
+        GstDetection *b = g_ptr_array_index(second, match);
+        gint marginX = ABS(b->bbox.x - a->bbox.x) / 2, marginY = ABS(b->bbox.y - a->bbox.y) / 2;
+        BoundingBox bbox = {
+            .x = interpolate(a->bbox.x, b->bbox.x, factor) - marginX,
+            .y = interpolate(a->bbox.y, b->bbox.y, factor) - marginY,
+            .width = MAX(interpolate(a->bbox.width, b->bbox.width, factor), 0) + 2 * marginX,
+            .height = MAX(interpolate(a->bbox.height, b->bbox.height, factor), 0) + 2 * marginY,
+        };
+        g_ptr_array_add(result, gst_detection_new(a->label, MIN(a->confidence, b->confidence), bbox));
+    }
+
+    g_free(used);
+
+    return result;
+}
+
+// Record the detections of a frame, detections are not modified afterwards
+void gst_detection_schedule_add(GstDetectionSchedule *self, GstClockTime pts, GPtrArray *detections)
+{
+    g_return_if_fail(GST_CLOCK_TIME_IS_VALID(pts));
+
+    ScheduleEntry entry = {
+        .pts = pts,
+        .detections = g_ptr_array_ref(detections),
+    };
+
+    g_mutex_lock(&self->mtxEntries);
+
+    // Frames arrive in order, unless upstream seeked
+    guint index = upper_bound(self->entries, pts);
+    if (index > 0 && g_array_index(self->entries, ScheduleEntry, index - 1).pts == pts)
+    {
+        ScheduleEntry *existing = &g_array_index(self->entries, ScheduleEntry, index - 1);
+        schedule_entry_clear(existing);
+        *existing = entry;
+    }
+    else
+        g_array_insert_val(self->entries, index, entry);
+
+    g_mutex_unlock(&self->mtxEntries);
+}
+
+// Get the detections of a frame from the schedule. Returns FALSE if the frame needs inference.
+gboolean gst_detection_schedule_lookup(GstDetectionSchedule *self, GstClockTime pts, gfloat minIou, GPtrArray **detections)
+{
+    gboolean ret = FALSE;
+    *detections = NULL;
+
+    if (!GST_CLOCK_TIME_IS_VALID(pts))
+        return FALSE;
+
+    g_mutex_lock(&self->mtxEntries);
+
+    // Frames after the last keyframe are not covered
+    guint index = upper_bound(self->entries, pts);
+    if (index == 0 || index == self->entries->len)
+        goto out;
+
+    ScheduleEntry *previous = &g_array_index(self->entries, ScheduleEntry, index - 1);
+    ScheduleEntry *next = &g_array_index(self->entries, ScheduleEntry, index);
+
+    // Frame is a keyframe itself
+    if (previous->pts == pts)
+    {
+        *detections = g_ptr_array_ref(previous->detections);
+        ret = TRUE;
+        goto out;
+    }
+
+    gdouble factor = (gdouble)(pts - previous->pts) / (next->pts - previous->pts);
+    *detections = interpolate_detections(previous->detections, next->detections, factor, minIou);
+    ret = *detections != NULL;
+
+out:
+    g_mutex_unlock(&self->mtxEntries);
+
+    return ret;
+}
+
+guint gst_detection_schedule_get_size(GstDetectionSchedule *self)
+{
+    g_mutex_lock(&self->mtxEntries);
+    guint size = self->entries->len;
+    g_mutex_unlock(&self->mtxEntries);
+
+    return size;
+}
+
+void gst_detection_schedule_init(GstDetectionSchedule *self)
+{
+    g_mutex_init(&self->mtxEntries);
+    self->entries = g_array_new(FALSE, FALSE, sizeof(ScheduleEntry));
+    g_array_set_clear_func(self->entries, (GDestroyNotify)schedule_entry_clear);
+}
+
+void gst_detection_schedule_finalize(GObject *object)
+{
+    GstDetectionSchedule *self = GST_DETECTION_SCHEDULE(object);
+
+    g_array_free(self->entries, TRUE);
+    g_mutex_clear(&self->mtxEntries);
+
+    G_OBJECT_CLASS(gst_detection_schedule_parent_class)->finalize(object);
+}
+
+void gst_detection_schedule_class_init(GstDetectionScheduleClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->finalize = gst_detection_schedule_finalize;
+}
+
+GstDetectionSchedule *gst_detection_schedule_new()
+{
+    return g_object_new(GST_TYPE_DETECTION_SCHEDULE, NULL);
+}
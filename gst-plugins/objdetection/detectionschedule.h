@@ -0,0 +1,46 @@
+#pragma once
+
+typedef struct _GstDetectionSchedule GstDetectionSchedule;
+typedef struct _GstDetectionScheduleClass GstDetectionScheduleClass;
+
+#include <gst/gst.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_DETECTION_SCHEDULE (gst_detection_schedule_get_type())
+#define GST_DETECTION_SCHEDULE(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_DETECTION_SCHEDULE, GstDetectionSchedule))
+#define GST_DETECTION_SCHEDULE_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_DETECTION_SCHEDULE, GstDetectionSchedule))
+#define GST_IS_DETECTION_SCHEDULE(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_DETECTION_SCHEDULE))
+#define GST_IS_DETECTION_SCHEDULE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_DETECTION_SCHEDULE))
+
+GType gst_detection_schedule_get_type(void) G_GNUC_CONST;
+
+typedef enum _GstDetectionScheduleMode GstDetectionScheduleMode;
+enum _GstDetectionScheduleMode
+{
+    GST_DETECTION_SCHEDULE_MODE_NONE,   // Schedule is ignored
+    GST_DETECTION_SCHEDULE_MODE_RECORD, // Detections of keyframes are added to the schedule
+    GST_DETECTION_SCHEDULE_MODE_REPLAY, // Detections are taken from the schedule where possible
+};
+
+// Detections of keyframes of a file, recorded in a first pass and replayed in a second one
+struct _GstDetectionSchedule
+{
+    GObject parent;
+
+    GMutex mtxEntries;
+    GArray *entries; // Sorted by timestamp
+};
+
+struct _GstDetectionScheduleClass
+{
+    GObjectClass parent_class;
+};
+
+G_END_DECLS
+
+GstDetectionSchedule *gst_detection_schedule_new();
+void gst_detection_schedule_add(GstDetectionSchedule *self, GstClockTime pts, GPtrArray *detections);
+gboolean gst_detection_schedule_lookup(GstDetectionSchedule *self, GstClockTime pts, gfloat minIou, GPtrArray **detections);
+guint gst_detection_schedule_get_size(GstDetectionSchedule *self);
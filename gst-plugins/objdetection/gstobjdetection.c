@@ -3,9 +3,16 @@
 #include "gstobjdetection.h"
 #include "inferencedata.h"
 #include "inferenceutil.h"
+#include "processmemory.h"
 
 #define LATENCY 0 // nanoseconds processing latency = time for inference
 #define THREAD_POOL_SIZE 4
+#define DEFAULT_INFERENCE_INTERVAL 1
+#define DEFAULT_WARMUP_RUNS 2
+#define DEFAULT_GATE_THRESHOLD 0.5
+#define DEFAULT_GATE_REFRESH_INTERVAL 30
+#define DEFAULT_TILE_OVERLAP 0.2
+#define SCHEDULE_MIN_IOU 0.3 // Minimum overlap of detections in consecutive keyframes to interpolate between them
 
 GST_DEBUG_CATEGORY(gst_obj_detection_debug);
 
@@ -16,6 +23,23 @@ enum
     PROP_PREFIX,
     PROP_ACTIVE,
     PROP_LABELS,
+    PROP_INFERENCE_INTERVAL,
+    PROP_SCHEDULE,
+    PROP_SCHEDULE_MODE,
+    PROP_GATE_MODEL_PATH,
+    PROP_GATE_THRESHOLD,
+    PROP_GATE_REFRESH_INTERVAL,
+    PROP_TILING,
+    PROP_TILE_OVERLAP,
+    PROP_WARMUP_RUNS,
+    PROP_EXECUTION_PROVIDER,
+    PROP_PROFILING,
+    PROP_PROFILING_DIR,
+    PROP_MEMORY_ARENA,
+    PROP_MEMORY_PATTERN,
+    PROP_ARENA_EXTEND_STRATEGY,
+    PROP_ARENA_SHRINKAGE,
+    PROP_STATS,
 };
 
 GstStaticPadTemplate obj_detection_src_template = GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
@@ -59,6 +83,8 @@ static void gst_obj_detection_set_property(GObject *object, guint prop_id, const
         break;
     case PROP_LABELS:
     {
+        GST_OBJECT_LOCK(filter);
+
         // Clear array
         while (filter->labels->len)
             g_ptr_array_remove_index(filter->labels, 0);
@@ -69,8 +95,63 @@ static void gst_obj_detection_set_property(GObject *object, guint prop_id, const
             const GValue *val = gst_value_array_get_value(value, i);
             g_ptr_array_add(filter->labels, g_value_dup_string(val));
         }
+
+        GST_OBJECT_UNLOCK(filter);
     }
     break;
+    case PROP_INFERENCE_INTERVAL:
+        filter->inferenceInterval = g_value_get_uint(value);
+        break;
+    case PROP_SCHEDULE:
+        if (filter->schedule)
+            g_object_unref(filter->schedule);
+        filter->schedule = g_value_dup_object(value);
+        break;
+    case PROP_SCHEDULE_MODE:
+        filter->scheduleMode = g_value_get_uint(value);
+        break;
+    case PROP_GATE_MODEL_PATH:
+        g_free((void *)filter->gateModelPath);
+        filter->gateModelPath = g_value_dup_string(value);
+        gst_inference_util_reinitialize(filter->gateUtil, filter);
+        break;
+    case PROP_GATE_THRESHOLD:
+        filter->gateThreshold = g_value_get_float(value);
+        break;
+    case PROP_GATE_REFRESH_INTERVAL:
+        filter->gateRefreshInterval = g_value_get_uint(value);
+        break;
+    case PROP_TILING:
+        filter->tiling = g_value_get_boolean(value);
+        break;
+    case PROP_TILE_OVERLAP:
+        filter->tileOverlap = g_value_get_float(value);
+        break;
+    case PROP_WARMUP_RUNS:
+        filter->warmupRuns = g_value_get_uint(value);
+        break;
+    case PROP_EXECUTION_PROVIDER:
+        filter->executionProvider = g_value_get_uint(value);
+        break;
+    case PROP_PROFILING:
+        filter->profiling = g_value_get_boolean(value);
+        break;
+    case PROP_PROFILING_DIR:
+        g_free((void *)filter->profilingDir);
+        filter->profilingDir = g_value_dup_string(value);
+        break;
+    case PROP_MEMORY_ARENA:
+        filter->memoryArena = g_value_get_boolean(value);
+        break;
+    case PROP_MEMORY_PATTERN:
+        filter->memoryPattern = g_value_get_boolean(value);
+        break;
+    case PROP_ARENA_EXTEND_STRATEGY:
+        filter->arenaExtendStrategy = g_value_get_uint(value);
+        break;
+    case PROP_ARENA_SHRINKAGE:
+        filter->arenaShrinkage = g_value_get_boolean(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -95,6 +176,7 @@ static void gst_obj_detection_get_property(GObject *object, guint prop_id, GValu
         break;
     case PROP_LABELS:
     {
+        GST_OBJECT_LOCK(filter);
         for (gint i = 0; i < filter->labels->len; i++)
         {
             GValue val = G_VALUE_INIT;
@@ -104,6 +186,68 @@ static void gst_obj_detection_get_property(GObject *object, guint prop_id, GValu
             gst_value_array_append_value(value, &val);
             g_value_unset(&val);
         }
+        GST_OBJECT_UNLOCK(filter);
+    }
+    break;
+    case PROP_INFERENCE_INTERVAL:
+        g_value_set_uint(value, filter->inferenceInterval);
+        break;
+    case PROP_SCHEDULE:
+        g_value_set_object(value, filter->schedule);
+        break;
+    case PROP_SCHEDULE_MODE:
+        g_value_set_uint(value, filter->scheduleMode);
+        break;
+    case PROP_GATE_MODEL_PATH:
+        g_value_set_string(value, filter->gateModelPath);
+        break;
+    case PROP_GATE_THRESHOLD:
+        g_value_set_float(value, filter->gateThreshold);
+        break;
+    case PROP_GATE_REFRESH_INTERVAL:
+        g_value_set_uint(value, filter->gateRefreshInterval);
+        break;
+    case PROP_TILING:
+        g_value_set_boolean(value, filter->tiling);
+        break;
+    case PROP_TILE_OVERLAP:
+        g_value_set_float(value, filter->tileOverlap);
+        break;
+    case PROP_WARMUP_RUNS:
+        g_value_set_uint(value, filter->warmupRuns);
+        break;
+    case PROP_EXECUTION_PROVIDER:
+        g_value_set_uint(value, filter->executionProvider);
+        break;
+    case PROP_PROFILING:
+        g_value_set_boolean(value, filter->profiling);
+        break;
+    case PROP_PROFILING_DIR:
+        g_value_set_string(value, filter->profilingDir);
+        break;
+    case PROP_MEMORY_ARENA:
+        g_value_set_boolean(value, filter->memoryArena);
+        break;
+    case PROP_MEMORY_PATTERN:
+        g_value_set_boolean(value, filter->memoryPattern);
+        break;
+    case PROP_ARENA_EXTEND_STRATEGY:
+        g_value_set_uint(value, filter->arenaExtendStrategy);
+        break;
+    case PROP_ARENA_SHRINKAGE:
+        g_value_set_boolean(value, filter->arenaShrinkage);
+        break;
+    case PROP_STATS:
+    {
+        // Report the provider in use, which differs from the requested one after a fallback
+        GstStructure *stats = gst_processing_stats_get_structure(filter->stats);
+        gst_structure_set(stats, "execution-provider", G_TYPE_STRING, gst_inference_provider_get_name(filter->inferenceUtil->provider),
+                          "process-memory-growth-at-load", G_TYPE_UINT64, gst_inference_util_get_memory_growth_at_load(filter->inferenceUtil), NULL);
+
+        guint64 resident, peak;
+        if (process_memory_get(&resident, &peak))
+            gst_structure_set(stats, "resident-memory", G_TYPE_UINT64, resident, "peak-memory", G_TYPE_UINT64, peak, NULL);
+        g_value_take_boxed(value, stats);
     }
     break;
     default:
@@ -126,6 +270,17 @@ static gboolean gst_obj_detection_start(GstObjDetection *filter)
 
     // Init inference
     gst_inference_util_initialize(filter->inferenceUtil, filter);
+    if (filter->gateModelPath)
+        gst_inference_util_initialize(filter->gateUtil, filter);
+
+    // Recording needs a schedule to record into, it can be read back after the run
+    if (filter->scheduleMode == GST_DETECTION_SCHEDULE_MODE_RECORD && !filter->schedule)
+        filter->schedule = gst_detection_schedule_new();
+
+    filter->framesSinceInference = 0;
+    filter->framesSinceDetection = 0;
+    gst_processing_stats_reset(filter->stats);
+    gst_qos_tracker_reset(filter->qos);
 
     // Start collect pads
     gst_collect_pads_start(filter->collectPads);
@@ -145,8 +300,10 @@ static gboolean gst_obj_detection_stop(GstObjDetection *filter)
         g_object_unref(filter->lastInferenceData);
     filter->lastInferenceData = NULL;
 
-    // Finalize inference
+    // Finalize inference, which also writes the traces of profiled sessions
     gst_inference_util_finalize(filter->inferenceUtil);
+    if (filter->gateUtil->initialized)
+        gst_inference_util_finalize(filter->gateUtil);
 
     return TRUE;
 }
@@ -159,6 +316,7 @@ static GstFlowReturn gst_obj_detection_aggregate_function(GstCollectPads *pads,
 
     GstBuffer *modelBuffer, *bypassBuffer;
     GstInferenceData *data, *lastInferenceData = NULL;
+    GstClockTime begin = gst_processing_stats_begin();
 
     // Get queued buffers
     modelBuffer = gst_collect_pads_pop(pads, filter->modelSinkData);
@@ -200,15 +358,80 @@ static GstFlowReturn gst_obj_detection_aggregate_function(GstCollectPads *pads,
             GST_DEBUG_OBJECT(filter, "No change, reusing detections");
             inference_couple(lastInferenceData, data);
             data->processed = TRUE;
-            goto output_buffer;
+            gst_processing_stats_add_skipped(filter->stats);
+            goto record;
         }
     }
     else
         GST_DEBUG_OBJECT(filter, "No change meta");
 
+    // Take detections from an earlier pass, interpolated between its keyframes
+    if (filter->scheduleMode == GST_DETECTION_SCHEDULE_MODE_REPLAY && filter->schedule)
+    {
+        GPtrArray *detections;
+        if (gst_detection_schedule_lookup(filter->schedule, GST_BUFFER_PTS(bypassBuffer), SCHEDULE_MIN_IOU, &detections))
+        {
+            GST_DEBUG_OBJECT(filter, "Detections taken from schedule");
+            g_ptr_array_unref(data->detections);
+            data->detections = detections;
+            data->processed = TRUE;
+            gst_processing_stats_add_skipped(filter->stats);
+            goto output_buffer;
+        }
+    }
+
+    // Skip inference for frames downstream reported to be too late for
+    GstClockTime runningTime = gst_segment_to_running_time(&filter->bypassSinkData->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(bypassBuffer));
+    if (lastInferenceData && gst_qos_tracker_is_late(filter->qos, runningTime))
+    {
+        GST_DEBUG_OBJECT(filter, "Buffer is late, reusing detections");
+        inference_couple(lastInferenceData, data);
+        data->processed = TRUE;
+        gst_processing_stats_add_skipped(filter->stats);
+        goto output_buffer;
+    }
+
+    // Only run inference on every n-th changed frame
+    if (filter->framesSinceInference + 1 < filter->inferenceInterval && lastInferenceData)
+    {
+        GST_DEBUG_OBJECT(filter, "Between inference intervals, reusing detections");
+        inference_couple(lastInferenceData, data);
+        data->processed = TRUE;
+        filter->framesSinceInference++;
+        gst_processing_stats_add_skipped(filter->stats);
+        goto output_buffer;
+    }
+
+    // Only run the detector if the gate model expects sensitive content, or from time to time to catch what it misses.
+    // The gate may only confirm that nothing is there: while the detector still sees something, a gate miss would
+    // remove the obstruction, so the detector keeps running until its detections are gone.
+    filter->framesSinceInference = 0;
+    if (filter->gateModelPath && filter->gateUtil->initialized && lastInferenceData && !lastInferenceData->error &&
+        lastInferenceData->detections->len == 0 &&
+        (filter->gateRefreshInterval == 0 || filter->framesSinceDetection + 1 < filter->gateRefreshInterval))
+    {
+        gfloat score;
+        if (gst_inference_util_run_gate(filter->gateUtil, filter, modelBuffer, &score) && score < filter->gateThreshold)
+        {
+            // Not recorded, only frames the detector ran on are keyframes of the schedule
+            GST_DEBUG_OBJECT(filter, "Gate did not fire, no detections");
+            data->processed = TRUE;
+            filter->framesSinceDetection++;
+            gst_processing_stats_add_skipped(filter->stats);
+            goto output_buffer;
+        }
+    }
+
     // Start processing
     gboolean success = gst_inference_util_run_inference(filter->inferenceUtil, filter, modelBuffer, bypassBuffer, data); // TODO: Think about only processing the last buffer on change
     data->error = !success;
+    filter->framesSinceDetection = 0;
+    gst_processing_stats_add_inference(filter->stats);
+
+record:
+    // Keep the detections of frames that are known to be correct as keyframes
+    if (filter->scheduleMode == GST_DETECTION_SCHEDULE_MODE_RECORD && filter->schedule && !data->error && GST_BUFFER_PTS_IS_VALID(bypassBuffer))
+        gst_detection_schedule_add(filter->schedule, GST_BUFFER_PTS(bypassBuffer), data->detections);
 
 output_buffer:
     // Apply detections (i.e. add to metadata)
@@ -218,8 +441,11 @@ output_buffer:
     if (data->error)
     {
         gst_buffer_unref(bypassBuffer);
+        gst_processing_stats_add_dropped(filter->stats);
+        gst_processing_stats_end(filter->stats, begin);
         goto skip_processing;
     }
+    gst_processing_stats_end(filter->stats, begin);
 
     // Push processed bypass buffer
     GST_LOG_OBJECT(filter, "Returning processed data %" GST_PTR_FORMAT, data);
@@ -246,6 +472,9 @@ static gboolean gst_obj_detection_src_event(GstPad *pad, GstObject *parent, GstE
 {
     GstObjDetection *filter = GST_OBJ_DETECTION(parent);
 
+    if (GST_EVENT_TYPE(event) == GST_EVENT_QOS)
+        gst_qos_tracker_update(filter->qos, event);
+
     return gst_collect_pads_src_event_default(filter->collectPads, pad, event);
 }
 
@@ -484,6 +713,20 @@ out:
         gst_query_unref(acceptCapsQuery);
 }
 
+// Replace the labels with the ones of a newly loaded model
+// Models may be loaded in the background, so listeners are notified about the change
+void gst_obj_detection_update_labels(GstObjDetection *filter, GPtrArray *labels)
+{
+    GST_OBJECT_LOCK(filter);
+    while (filter->labels->len)
+        g_ptr_array_remove_index(filter->labels, 0);
+    for (gint i = 0; i < labels->len; i++)
+        g_ptr_array_add(filter->labels, g_strdup(g_ptr_array_index(labels, i)));
+    GST_OBJECT_UNLOCK(filter);
+
+    g_object_notify(G_OBJECT(filter), "labels");
+}
+
 // Object constructor -> called for every instance
 static void gst_obj_detection_init(GstObjDetection *filter)
 {
@@ -523,6 +766,26 @@ static void gst_obj_detection_init(GstObjDetection *filter)
     filter->modelPath = NULL;
     filter->prefix = NULL;
     filter->active = TRUE;
+    filter->inferenceInterval = DEFAULT_INFERENCE_INTERVAL;
+    filter->schedule = NULL;
+    filter->scheduleMode = GST_DETECTION_SCHEDULE_MODE_NONE;
+    filter->gateModelPath = NULL;
+    filter->gateThreshold = DEFAULT_GATE_THRESHOLD;
+    filter->gateRefreshInterval = DEFAULT_GATE_REFRESH_INTERVAL;
+    filter->framesSinceDetection = 0;
+    filter->tiling = FALSE;
+    filter->tileOverlap = DEFAULT_TILE_OVERLAP;
+    filter->warmupRuns = DEFAULT_WARMUP_RUNS;
+    filter->executionProvider = GST_INFERENCE_PROVIDER_DEFAULT;
+    filter->profiling = FALSE;
+    filter->profilingDir = NULL;
+    filter->memoryArena = TRUE;
+    filter->memoryPattern = TRUE;
+    filter->arenaExtendStrategy = GST_INFERENCE_ARENA_EXTEND_POWER_OF_TWO;
+    filter->arenaShrinkage = FALSE;
+
+    filter->stats = gst_processing_stats_new(GST_ELEMENT(filter));
+    filter->qos = gst_qos_tracker_new();
 
     filter->labels = g_ptr_array_new_with_free_func(g_free);
 
@@ -533,6 +796,7 @@ static void gst_obj_detection_init(GstObjDetection *filter)
 
     // Init inference utils
     filter->inferenceUtil = gst_inference_util_new();
+    filter->gateUtil = gst_inference_util_new_gate();
 }
 
 // Object destructor -> called if an object gets destroyed
@@ -542,15 +806,24 @@ static void gst_obj_detection_finalize(GObject *object)
 
     g_free((void *)filter->modelPath);
     g_free((void *)filter->prefix);
+    g_free((void *)filter->profilingDir);
+    g_free((void *)filter->gateModelPath);
 
     g_ptr_array_free(filter->labels, TRUE);
 
+    if (filter->schedule)
+        g_object_unref(filter->schedule);
+
+    gst_processing_stats_free(filter->stats);
+    gst_qos_tracker_free(filter->qos);
+
     g_clear_object(&(filter->collectPads));
     g_clear_object(&(filter->bypassSink));
     g_clear_object(&(filter->modelSink));
     g_clear_object(&(filter->source));
 
     g_object_unref(filter->inferenceUtil);
+    g_object_unref(filter->gateUtil);
 
     // Clear modelSinkCaps
     if (filter->modelSinkCaps)
@@ -598,6 +871,85 @@ static void gst_obj_detection_class_init(GstObjDetectionClass *klass)
                                                                              NULL,
                                                                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_INFERENCE_INTERVAL,
+                                    g_param_spec_uint("inference-interval", "Inference interval",
+                                                      "Run inference on every n-th changed frame only, reusing the detections in between",
+                                                      1, G_MAXUINT, DEFAULT_INFERENCE_INTERVAL,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_SCHEDULE,
+                                    g_param_spec_object("schedule", "Schedule",
+                                                        "Detections of keyframes, shared between a recording and a replaying pass over the same file",
+                                                        GST_TYPE_DETECTION_SCHEDULE,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_SCHEDULE_MODE,
+                                    g_param_spec_uint("schedule-mode", "Schedule mode",
+                                                      "Whether detections are recorded into (1) or replayed from (2) the schedule, 0 to ignore it",
+                                                      GST_DETECTION_SCHEDULE_MODE_NONE, GST_DETECTION_SCHEDULE_MODE_REPLAY, GST_DETECTION_SCHEDULE_MODE_NONE,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_GATE_MODEL_PATH,
+                                    g_param_spec_string("gate-model-path", "Gate model path",
+                                                        "Path to a small classifier or detector that decides whether the detection model runs on a changed frame", NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_GATE_THRESHOLD,
+                                    g_param_spec_float("gate-threshold", "Gate threshold",
+                                                       "Minimum score of the gate model for the detection model to run",
+                                                       0, 1, DEFAULT_GATE_THRESHOLD,
+                                                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_GATE_REFRESH_INTERVAL,
+                                    g_param_spec_uint("gate-refresh-interval", "Gate refresh interval",
+                                                      "Run the detection model on every n-th inferred frame regardless of the gate, 0 to always follow the gate",
+                                                      0, G_MAXUINT, DEFAULT_GATE_REFRESH_INTERVAL,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_TILING,
+                                    g_param_spec_boolean("tiling", "Tiling",
+                                                         "Also detect on model-sized tiles of the full resolution frame, only tiles with changes are inferred",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_TILE_OVERLAP,
+                                    g_param_spec_float("tile-overlap", "Tile overlap",
+                                                       "Share of the tile size neighbouring tiles overlap by, so that content on tile borders is fully inside a tile",
+                                                       0, 0.9, DEFAULT_TILE_OVERLAP,
+                                                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_WARMUP_RUNS,
+                                    g_param_spec_uint("warmup-runs", "Warm-up runs",
+                                                      "Inferences on a blank frame after loading a model, so that the first frames do not pay for lazy initialization",
+                                                      0, G_MAXUINT, DEFAULT_WARMUP_RUNS,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_EXECUTION_PROVIDER,
+                                    g_param_spec_uint("execution-provider", "Execution provider",
+                                                      "Onnxruntime execution provider: default CPU (0), oneDNN (1) or XNNPACK (2). Falls back to the default one if unavailable, applied on start",
+                                                      GST_INFERENCE_PROVIDER_DEFAULT, GST_INFERENCE_PROVIDER_XNNPACK, GST_INFERENCE_PROVIDER_DEFAULT,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_PROFILING,
+                                    g_param_spec_boolean("profiling", "Profiling",
+                                                         "Record an onnxruntime trace of all inferences and post a summary of the most expensive operators on stop, applied on start",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_PROFILING_DIR,
+                                    g_param_spec_string("profiling-dir", "Profiling directory",
+                                                        "Directory the traces are written to, defaults to the temporary directory", NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_MEMORY_ARENA,
+                                    g_param_spec_boolean("memory-arena", "Memory arena",
+                                                         "Whether onnxruntime keeps freed memory in an arena for reuse, applied on start",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_MEMORY_PATTERN,
+                                    g_param_spec_boolean("memory-pattern", "Memory pattern",
+                                                         "Whether onnxruntime plans the allocations of an inference from the previous ones, applied on start",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_ARENA_EXTEND_STRATEGY,
+                                    g_param_spec_uint("arena-extend-strategy", "Arena extend strategy",
+                                                      "Grow the arena of each session in powers of two (0) or a single arena shared by all sessions by the requested size (1), applied on start",
+                                                      GST_INFERENCE_ARENA_EXTEND_POWER_OF_TWO, GST_INFERENCE_ARENA_EXTEND_SAME_AS_REQUESTED, GST_INFERENCE_ARENA_EXTEND_POWER_OF_TWO,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_ARENA_SHRINKAGE,
+                                    g_param_spec_boolean("arena-shrinkage", "Arena shrinkage",
+                                                         "Return unused arena memory to the system after every inference, applied on start",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(gobject_class, PROP_STATS, gst_processing_stats_param_spec());
 
     // Set plugin metadata
     gst_element_class_set_static_metadata(gstelement_class,
@@ -7,6 +7,9 @@ typedef struct _GstObjDetectionClass GstObjDetectionClass;
 #include <gst/base/gstcollectpads.h>
 #include "inferencedata.h"
 #include "inferenceutil.h"
+#include "detectionschedule.h"
+#include <processingstats.h>
+#include <qostracker.h>
 
 G_BEGIN_DECLS
 
@@ -35,7 +38,30 @@ struct _GstObjDetection
     GPtrArray *labels;
     gboolean active;
 
+    guint inferenceInterval, framesSinceInference;
+    GstDetectionSchedule *schedule;
+    GstDetectionScheduleMode scheduleMode;
+
+    const char *gateModelPath; // Optional cheap model that decides whether the detector runs
+    gfloat gateThreshold;
+    guint gateRefreshInterval, framesSinceDetection;
+
+    gboolean tiling; // Detect on tiles of the full resolution frame in addition to the downscaled frame
+    gfloat tileOverlap;
+
+    guint warmupRuns;
+    GstInferenceProvider executionProvider;
+    gboolean profiling;
+    const char *profilingDir;
+
+    gboolean memoryArena, memoryPattern, arenaShrinkage;
+    GstInferenceArenaExtend arenaExtendStrategy;
+
+    GstProcessingStats *stats;
+    GstQosTracker *qos;
+
     GstInferenceUtil *inferenceUtil;
+    GstInferenceUtil *gateUtil;
 };
 
 struct _GstObjDetectionClass
@@ -44,5 +70,6 @@ struct _GstObjDetectionClass
 };
 
 void gst_obj_detection_reconfigure_model_sink(GstObjDetection *filter, gint modelProportions);
+void gst_obj_detection_update_labels(GstObjDetection *filter, GPtrArray *labels);
 
 G_END_DECLS
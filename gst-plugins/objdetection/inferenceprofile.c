@@ -0,0 +1,117 @@
+#include "inferenceprofile.h"
+
+typedef struct _OperatorCost OperatorCost;
+struct _OperatorCost
+{
+    const gchar *name; // Owned by the operator table
+    guint64 time;      // Nanoseconds
+    guint count;
+};
+
+static gint compare_costs(gconstpointer a, gconstpointer b)
+{
+    const OperatorCost *costA = *(const OperatorCost **)a;
+    const OperatorCost *costB = *(const OperatorCost **)b;
+
+    return costA->time < costB->time ? 1 : (costA->time > costB->time ? -1 : 0);
+}
+
+// Get the first capture of a regex in a line, NULL if it does not match
+static gchar *match_field(GRegex *regex, const gchar *line)
+{
+    GMatchInfo *matchInfo;
+    gchar *value = NULL;
+
+    if (g_regex_match(regex, line, 0, &matchInfo))
+        value = g_match_info_fetch(matchInfo, 1);
+    g_match_info_free(matchInfo);
+
+    return value;
+}
+
+// Onnxruntime writes a chrome trace with one event per line. Each node execution is a "Node" event named
+// "<node>_kernel_time" with its duration in microseconds and the operator type in its arguments.
+GstStructure *inference_profile_summarize(const gchar *path, guint hotspotCount)
+{
+    gchar *contents;
+    if (!g_file_get_contents(path, &contents, NULL, NULL))
+        return NULL;
+
+    GRegex *nodeRegex = g_regex_new("\"cat\"\\s*:\\s*\"Node\".*\"name\"\\s*:\\s*\"[^\"]*_kernel_time\"", G_REGEX_OPTIMIZE, 0, NULL);
+    GRegex *durationRegex = g_regex_new("\"dur\"\\s*:\\s*(\\d+)", G_REGEX_OPTIMIZE, 0, NULL);
+    GRegex *operatorRegex = g_regex_new("\"op_name\"\\s*:\\s*\"([^\"]*)\"", G_REGEX_OPTIMIZE, 0, NULL);
+
+    GHashTable *operators = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free); // Operator type -> OperatorCost
+    guint64 totalTime = 0;
+
+    gchar **lines = g_strsplit(contents, "\n", -1);
+    for (gint i = 0; lines[i]; i++)
+    {
+        if (!g_regex_match(nodeRegex, lines[i], 0, NULL))
+            continue;
+
+        gchar *duration = match_field(durationRegex, lines[i]);
+        gchar *opName = match_field(operatorRegex, lines[i]);
+        if (duration && opName)
+        {
+            OperatorCost *cost = g_hash_table_lookup(operators, opName);
+            if (cost == NULL)
+            {
+                cost = g_new0(OperatorCost, 1);
+                cost->name = opName;
+                g_hash_table_insert(operators, opName, cost);
+                opName = NULL; // Owned by the table now
+            }
+
+            guint64 time = g_ascii_strtoull(duration, NULL, 10) * GST_USECOND;
+            cost->time += time;
+            cost->count++;
+            totalTime += time;
+        }
+
+        g_free(duration);
+        g_free(opName);
+    }
+
+    // Most expensive operator types first
+    GHashTableIter iter;
+    gpointer cost;
+    GPtrArray *costs = g_ptr_array_new();
+    g_hash_table_iter_init(&iter, operators);
+    while (g_hash_table_iter_next(&iter, NULL, &cost))
+        g_ptr_array_add(costs, cost);
+    g_ptr_array_sort(costs, compare_costs);
+
+    GValue hotspots = G_VALUE_INIT;
+    gst_value_array_init(&hotspots, MIN(costs->len, hotspotCount));
+    for (guint i = 0; i < costs->len && i < hotspotCount; i++)
+    {
+        OperatorCost *operatorCost = g_ptr_array_index(costs, i);
+
+        GValue value = G_VALUE_INIT;
+        g_value_init(&value, GST_TYPE_STRUCTURE);
+        g_value_take_boxed(&value, gst_structure_new("operator",
+                                                     "name", G_TYPE_STRING, operatorCost->name,
+                                                     "time", G_TYPE_UINT64, operatorCost->time,
+                                                     "count", G_TYPE_UINT, operatorCost->count,
+                                                     "share", G_TYPE_DOUBLE, totalTime ? (gdouble)operatorCost->time / totalTime : 0.0,
+                                                     NULL));
+        gst_value_array_append_and_take_value(&hotspots, &value);
+    }
+
+    GstStructure *summary = gst_structure_new(GST_INFERENCE_PROFILE_NAME,
+                                              "file", G_TYPE_STRING, path,
+                                              "total", G_TYPE_UINT64, totalTime,
+                                              NULL);
+    gst_structure_take_value(summary, "hotspots", &hotspots);
+
+    g_ptr_array_unref(costs);
+    g_hash_table_destroy(operators);
+    g_strfreev(lines);
+    g_regex_unref(nodeRegex);
+    g_regex_unref(durationRegex);
+    g_regex_unref(operatorRegex);
+    g_free(contents);
+
+    return summary;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_INFERENCE_PROFILE_NAME "sps-inference-profile" // Name of the profile summary structure and the element message carrying it
+
+// Summarize an onnxruntime profiling trace by the time spent per operator type
+// Returns NULL if the trace cannot be read
+GstStructure *inference_profile_summarize(const gchar *path, guint hotspotCount);
+
+G_END_DECLS
@@ -1,12 +1,15 @@
 #include "inferenceutil.h"
 #include "inferencedata.h"
 #include "gstobjdetection.h"
+#include "inferenceprofile.h"
+#include "processmemory.h"
 // TODO: Find a way to run yolo on the GPU platform independently
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <onnxruntime_c_api.h>
 #include <detectionmeta.h>
+#include <changemeta.h>
 #ifdef WIN32
 #include <Windows.h>
 #include <gmodule.h>
@@ -26,12 +29,28 @@
 #define SMALL_DETECTION_COUNT(modelProportion) MODEL_SIZE(modelProportion) / (32 * 32) * 3                                                                                    // Number of detections in the smallest output
 #define EXPECTED_DETECTION_COUNT(modelProportion) (LARGE_DETECTION_COUNT(modelProportion) + MEDIUM_DETECTION_COUNT(modelProportion) + SMALL_DETECTION_COUNT(modelProportion)) // Total numbers of detections
 
+#define ANCHOR_FREE_DETECTION_COUNT(modelProportion) (MODEL_SIZE(modelProportion) / (8 * 8) + MODEL_SIZE(modelProportion) / (16 * 16) + MODEL_SIZE(modelProportion) / (32 * 32)) // One detection per cell of each scale
+
 #define SINGLE_DETECTION_SIZE(classCount) (classCount + 5)
 #define EXPECTED_DETECTION_SIZE(classCount, modelProportion) (SINGLE_DETECTION_SIZE(classCount) * EXPECTED_DETECTION_COUNT(modelProportion)) // Total number of data elements (floats)
 
+#define MAX_OUTPUT_COUNT 4 // Outputs a layout reads at most
+#define MAX_TILE_BATCH 8   // Tiles inferred at once by models with a dynamic batch size, bounds the memory of the input
+
+// Order of the outputs requested from end-to-end models
+enum
+{
+    END_TO_END_NUM,
+    END_TO_END_BOXES,
+    END_TO_END_SCORES,
+    END_TO_END_CLASSES,
+};
+
 #define INFERENCE_THREAD_COUNT 4
 #define OBJ_PROB_THRESHOLD 0.25
 #define IOU_THRESHOLD 0.45
+#define PROFILE_HOTSPOT_COUNT 10
+#define PROFILING_DIR_ENV "SPS_INFERENCE_PROFILING_DIR" // Enables profiling for all detection elements
 
 #define GOTO_IF(assertion, label) \
     if (assertion)                \
@@ -39,6 +58,19 @@
 
 G_DEFINE_TYPE(GstInferenceUtil, gst_inference_util, G_TYPE_OBJECT);
 
+// Sessions are shared between all elements of a process that use the same model (e.g. parallel file pipelines).
+// Running a single session from several threads is supported by onnxruntime.
+typedef struct _SharedSession SharedSession;
+struct _SharedSession
+{
+    OrtSession *session;
+    guint refCount;
+    gboolean warm; // Whether a warm-up has already run on the session
+};
+
+static GMutex mtxSharedSessions;
+static GHashTable *sharedSessions = NULL; // Session key -> SharedSession
+
 typedef struct _Coordinate Coordinate;
 struct _Coordinate
 {
@@ -54,6 +86,13 @@ struct _WorkPackage
     gfloat *out;
 };
 
+// Model-sized part of the full resolution frame
+typedef struct _Tile Tile;
+struct _Tile
+{
+    gint x, y;
+};
+
 static const gfloat scales[3] = {1.2f, 1.1f, 1.05f}; // large -> large
 static const gint8 strides[3] = {8, 16, 32};         // large -> small
 // large -> small, 3 each
@@ -154,7 +193,7 @@ static void non_max_suppression(GPtrArray *detections, GPtrArray *out)
 
             if (iou(bestDetection, element) > IOU_THRESHOLD)
             {
-                g_ptr_array_remove_index(detections, i);
+                g_object_unref(g_ptr_array_remove_index(detections, i));
                 i--; // Remaining elements shift back by one, so we need to check the same index again
             }
         }
@@ -206,6 +245,68 @@ static void parse_detections(gfloat *detections, gint detectionCount, gint class
     }
 }
 
+// Scale a box from the model input to the target size and clip it
+static BoundingBox scale_box(gfloat x, gfloat y, gfloat width, gfloat height, gfloat ratioX, gfloat ratioY, gint targetWidth, gint targetHeight)
+{
+    BoundingBox bbox;
+    bbox.x = MAX(MIN((gint)roundf(x * ratioX), targetWidth), 0);
+    bbox.y = MAX(MIN((gint)roundf(y * ratioY), targetHeight), 0);
+    bbox.width = MAX(MIN((gint)roundf(width * ratioX), targetWidth - bbox.x), 0);
+    bbox.height = MAX(MIN((gint)roundf(height * ratioY), targetHeight - bbox.y), 0);
+
+    return bbox;
+}
+
+// Create a detection labeled "<prefix>:<label>", or "<prefix>:<class index>" if the model has no label for the class
+static GstDetection *new_detection(const char *labelPrefix, GPtrArray *labels, gint classIndex, gfloat confidence, BoundingBox bbox)
+{
+    GString *label = g_string_new(labelPrefix);
+    if (classIndex >= 0 && classIndex < labels->len)
+        g_string_append_printf(label, ":%s", (const char *)g_ptr_array_index(labels, classIndex));
+    else
+        g_string_append_printf(label, ":%i", classIndex);
+
+    GstDetection *detection = gst_detection_new(label->str, confidence, bbox);
+    g_string_free(label, TRUE);
+
+    return detection;
+}
+
+// Get the data of an output tensor together with its element type and element count
+static OrtStatusPtr get_tensor(const OrtApi *ort, OrtValue *value, void **data, ONNXTensorElementDataType *type, size_t *count)
+{
+    OrtTensorTypeAndShapeInfo *info;
+    OrtStatusPtr status = ort->GetTensorTypeAndShape(value, &info);
+    if (status != NULL)
+        return status;
+
+    status = ort->GetTensorElementType(info, type);
+    if (status == NULL)
+        status = ort->GetTensorShapeElementCount(info, count);
+    ort->ReleaseTensorTypeAndShapeInfo(info);
+
+    if (status == NULL)
+        status = ort->GetTensorMutableData(value, data);
+
+    return status;
+}
+
+// Read a single element of a tensor, exported models differ in the types of their outputs
+static gdouble tensor_value(const void *data, ONNXTensorElementDataType type, size_t index)
+{
+    switch (type)
+    {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+        return ((const gdouble *)data)[index];
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+        return ((const gint32 *)data)[index];
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+        return ((const gint64 *)data)[index];
+    default:
+        return ((const gfloat *)data)[index];
+    }
+}
+
 // Convert single image line
 static void convert_row(WorkPackage *package)
 {
@@ -244,6 +345,75 @@ static void image_to_float(gint width, gint height, guint8 *in, gfloat *out)
     g_thread_pool_free(pool, FALSE, TRUE);
 }
 
+// Nearest neighbour scaling of a square BGRA frame, e.g. for a gate model with another input size than the detector
+static guint8 *scale_frame(const guint8 *in, gint inProportion, gint outProportion)
+{
+    guint32 *out = g_malloc(MODEL_SIZE(outProportion) * INPUT_CHANNELS);
+    const guint32 *inPixels = (const guint32 *)in;
+
+    for (gint row = 0; row < outProportion; row++)
+    {
+        const guint32 *inRow = &inPixels[(row * inProportion / outProportion) * inProportion];
+        for (gint col = 0; col < outProportion; col++)
+            out[row * outProportion + col] = inRow[col * inProportion / outProportion];
+    }
+
+    return (guint8 *)out;
+}
+
+// Positions of the tiles along one axis of the frame, the last tile is aligned with the end of the frame
+static GArray *tile_positions(gint length, gint proportion, gfloat overlap)
+{
+    GArray *positions = g_array_new(FALSE, FALSE, sizeof(gint));
+    gint step = MAX((gint)(proportion * (1 - overlap)), 1);
+
+    for (gint position = 0;; position += step)
+    {
+        gint aligned = MAX(MIN(position, length - proportion), 0);
+        g_array_append_val(positions, aligned);
+
+        if (position + proportion >= length)
+            break;
+    }
+
+    return positions;
+}
+
+// Copy a tile of a BGRA frame to the planar RGB float input of the model, parts outside of the frame stay black
+static void tile_to_float(const guint8 *frame, gint stride, gint width, gint height, const Tile *tile, gint proportion, gfloat *out)
+{
+    memset(out, 0, EXPECTED_MODEL_SIZE(proportion) * sizeof(gfloat));
+
+    const gint rows = MIN(proportion, height - tile->y);
+    const gint cols = MIN(proportion, width - tile->x);
+    for (gint row = 0; row < rows; row++)
+    {
+        const guint8 *in = frame + (gsize)(tile->y + row) * stride + tile->x * INPUT_CHANNELS;
+        for (gint col = 0; col < cols; col++)
+        {
+            for (gint chan = 0; chan < MODEL_CHANNELS; chan++)
+                out[row * proportion + col + (MODEL_CHANNELS - chan - 1) * MODEL_SIZE(proportion)] = in[col * INPUT_CHANNELS + chan] / 255.0f;
+        }
+    }
+}
+
+// Whether any change region overlaps the tile, frames without regions count as changed everywhere
+static gboolean tile_changed(GstChangeMeta *changeMeta, const Tile *tile, gint proportion)
+{
+    if (!changeMeta || changeMeta->regions->len == 0)
+        return TRUE;
+
+    for (guint i = 0; i < changeMeta->regions->len; i++)
+    {
+        BoundingBox *region = &g_array_index(changeMeta->regions, BoundingBox, i);
+        if (region->x < tile->x + proportion && region->x + region->width > tile->x &&
+            region->y < tile->y + proportion && region->y + region->height > tile->y)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 // -----------------------------------------------------------------------------------------------------
 // ----------------------------------------- Public Helpers --------------------------------------------
 // -----------------------------------------------------------------------------------------------------
@@ -281,23 +451,25 @@ gboolean inference_apply(GstObjDetection *objDet, GstBuffer *bypassBuffer, GstIn
 // -----------------------------------------------------------------------------------------------------
 
 // Process frame before inference
-static void gst_inference_util_preprocess(GstInferenceUtil *self, guint8 *rawData, gfloat *processedData)
+static void gst_inference_util_preprocess(GstInferenceUtil *self, GstInferenceModel *model, guint8 *rawData, gfloat *processedData)
 {
-    image_to_float(self->modelProportion, self->modelProportion, rawData, processedData);
+    image_to_float(model->modelProportion, model->modelProportion, rawData, processedData);
 }
 
-// Perform actual inference and extracts the output
-static void gst_inference_util_infer(GstInferenceUtil *self, OrtStatus **status, gfloat *processedData, gfloat *outDetections)
+// Perform actual inference, the outputs requested by the layout of the model have to be released by the caller
+// Several frames can be inferred at once if the model has a dynamic batch size
+static void gst_inference_util_infer(GstInferenceUtil *self, GstInferenceModel *model, OrtStatus **status, gfloat *processedData, gint batchSize, OrtValue **outputs)
 {
+    OrtMemoryInfo *memoryInfo = NULL;
+    OrtValue *inputTensor = NULL;
+
     // Prepare memory for input tensor
-    OrtMemoryInfo *memoryInfo;
     *status = self->ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memoryInfo);
     GOTO_IF(*status != NULL, out);
 
     // Set input tensor from preprocessed data
-    const gint64 shape[4] = {1, 3, self->modelProportion, self->modelProportion};
-    OrtValue *inputTensor;
-    *status = self->ort->CreateTensorWithDataAsOrtValue(memoryInfo, processedData, EXPECTED_MODEL_SIZE(self->modelProportion) * sizeof(gfloat), shape, 4, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &inputTensor);
+    const gint64 shape[4] = {batchSize, 3, model->modelProportion, model->modelProportion};
+    *status = self->ort->CreateTensorWithDataAsOrtValue(memoryInfo, processedData, batchSize * EXPECTED_MODEL_SIZE(model->modelProportion) * sizeof(gfloat), shape, 4, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &inputTensor);
     GOTO_IF(*status != NULL, out);
 
     // Check correct creation
@@ -305,143 +477,418 @@ static void gst_inference_util_infer(GstInferenceUtil *self, OrtStatus **status,
     *status = self->ort->IsTensor(inputTensor, &isTensor);
     GOTO_IF(*status != NULL || !isTensor, out);
 
-    // Define the output tensor
-    OrtValue *outputTensor = NULL;
-
-    // Define the names of the input and output neurons
-    const char *inputNodeName = "images";
-    const char *outputNodeName = "output"; // Combined (10647 x (5 + CLASS_COUNT)) = (52*52*3 + 26*26*3 + 13*13*3) x (5 + CLASS_COUNT)
-
     // Run inference
-    g_mutex_lock(&self->mtxBlocked);
-    while (self->sessionBlocked)
-        g_cond_wait(&self->condBlocked, &self->mtxBlocked);
-    g_mutex_unlock(&self->mtxBlocked);
-
-    g_mutex_lock(&self->mtxRefCount);
-    self->sessionRefCount++; // No need to signal here, as increasing the refcount won't lead to a success case anyways
-    g_mutex_unlock(&self->mtxRefCount);
+    const char *inputNodeName = model->inputName;
+    *status = self->ort->Run(model->session, self->runOptions, &inputNodeName, (const OrtValue *const *)&inputTensor, 1,
+                             (const char *const *)model->outputNames, model->outputCount, outputs);
+    GOTO_IF(*status != NULL, out);
 
-    *status = self->ort->Run(self->session, NULL, &inputNodeName, (const OrtValue *const *)&inputTensor, 1, &outputNodeName, 1, &outputTensor);
+out:
+    if (inputTensor)
+        self->ort->ReleaseValue(inputTensor);
+    if (memoryInfo)
+        self->ort->ReleaseMemoryInfo(memoryInfo);
+}
 
-    g_mutex_lock(&self->mtxRefCount);
-    self->sessionRefCount--;
-    g_cond_signal(&self->condRefCount); // Signal potentially waiting reinit thread
-    g_mutex_unlock(&self->mtxRefCount);
+// Release the outputs of an inference
+static void gst_inference_util_release_outputs(GstInferenceUtil *self, OrtValue **outputs)
+{
+    for (gint i = 0; i < MAX_OUTPUT_COUNT; i++)
+    {
+        if (outputs[i])
+            self->ort->ReleaseValue(outputs[i]);
+        outputs[i] = NULL;
+    }
+}
 
-    GOTO_IF(*status != NULL, out);
+// Performs non maximum suppression per class on the candidate detections, which are moved to the output or freed
+static void suppress_per_class(GPtrArray *detections, GPtrArray *out)
+{
+    // Sort the detections by class to get same classes next one another
+    g_ptr_array_sort(detections, (GCompareFunc)compare_detections);
 
-    // Check correct inference and get pointer to detections
-    gfloat *detections;
-    *status = self->ort->IsTensor(outputTensor, &isTensor);
-    GOTO_IF(*status != NULL || !isTensor, out);
+    // Do non maximum suppression per class, NMS removes all elements from the group so it can be reused
+    GPtrArray *group = g_ptr_array_new();
+    for (gint i = 0; i < detections->len; i++)
+    {
+        GstDetection *element = g_ptr_array_index(detections, i);
 
-    *status = self->ort->GetTensorMutableData(outputTensor, (void **)&detections);
-    GOTO_IF(*status != NULL, out);
+        // New label at this index, so the last group is complete
+        if (group->len > 0 && g_strcmp0(element->label, ((GstDetection *)g_ptr_array_index(group, 0))->label) != 0)
+            non_max_suppression(group, out);
 
-    // Copy prediction data
-    parse_detections(detections, EXPECTED_DETECTION_COUNT(self->modelProportion), self->classCount, outDetections);
+        g_ptr_array_add(group, element);
+    }
 
-out:
-    self->ort->ReleaseValue(outputTensor);
-    self->ort->ReleaseMemoryInfo(memoryInfo);
+    // Handle last group
+    non_max_suppression(group, out);
+    g_ptr_array_free(group, TRUE);
+    g_ptr_array_set_size(detections, 0);
 }
 
 // Performs all necessary output steps to get detections from the raw data
 // Scales the coordinates to the original input size
 // Filters detections with low object probability
 // Performs non maximum suppression on the remaining detections
-static void gst_inference_util_postprocess(GstInferenceUtil *self, gfloat *rawDetections, GPtrArray *out, const char *labelPrefix, GPtrArray *labels, gint targetWidth, gint targetHeight)
+static void gst_inference_util_postprocess(GstInferenceUtil *self, GstInferenceModel *model, gfloat *rawDetections, GPtrArray *out, const char *labelPrefix, GPtrArray *labels, gint targetWidth, gint targetHeight)
 {
-    const gfloat ratioX = (gfloat)targetWidth / self->modelProportion;
-    const gfloat ratioY = (gfloat)targetHeight / self->modelProportion;
+    const gfloat ratioX = (gfloat)targetWidth / model->modelProportion;
+    const gfloat ratioY = (gfloat)targetHeight / model->modelProportion;
 
     // Get the highest scoring class and its score for each detection
     GPtrArray *detections = g_ptr_array_new();
-    for (gint i = 0; i < EXPECTED_DETECTION_COUNT(self->modelProportion); i++)
+    for (gint i = 0; i < EXPECTED_DETECTION_COUNT(model->modelProportion); i++)
     {
-        gint offset = i * SINGLE_DETECTION_SIZE(self->classCount);
+        gint offset = i * SINGLE_DETECTION_SIZE(model->classCount);
 
         gfloat objProp = rawDetections[offset + 4];
         if (objProp < OBJ_PROB_THRESHOLD)
             continue;
 
-        gint x, y, width, height;
-        gfloat *classProbs = g_malloc(sizeof(gfloat) * self->classCount);
+        gint maxConfLabel;
+        gfloat maxConfScore;
+        array_max(&rawDetections[offset + 5], model->classCount, &maxConfLabel, &maxConfScore);
 
-        x = (int)roundf(rawDetections[offset + 0] * ratioX);
-        y = (int)roundf(rawDetections[offset + 1] * ratioY);
-        width = (int)roundf(rawDetections[offset + 2] * ratioX);
-        height = (int)roundf(rawDetections[offset + 3] * ratioY);
-        memcpy(classProbs, &rawDetections[offset + 5], self->classCount * sizeof(gfloat));
+        BoundingBox bbox = scale_box(rawDetections[offset + 0], rawDetections[offset + 1], rawDetections[offset + 2], rawDetections[offset + 3],
+                                     ratioX, ratioY, targetWidth, targetHeight);
+        g_ptr_array_add(detections, new_detection(labelPrefix, labels, maxConfLabel, maxConfScore, bbox));
+    }
 
-        // Clip bounding boxes
-        x = MAX(MIN(x, targetWidth), 0);
-        y = MAX(MIN(y, targetHeight), 0);
-        width = MAX(MIN(width, targetWidth - x), 0);
-        height = MAX(MIN(height, targetHeight - y), 0);
+    suppress_per_class(detections, out);
+    g_ptr_array_free(detections, FALSE);
+}
 
-        gint maxConfLabel;
-        gfloat maxConfScore;
-        array_max(classProbs, self->classCount, &maxConfLabel, &maxConfScore);
-
-        GString *label = g_string_new(labelPrefix);
-        if (maxConfLabel < labels->len)
-            g_string_append_printf(label, ":%s", g_ptr_array_index(labels, maxConfLabel));
-        else
-            g_string_append_printf(label, ":%i", maxConfLabel);
-
-        BoundingBox bbox = {
-            .x = x,
-            .y = y,
-            .width = width,
-            .height = height,
-        };
-        GstDetection *detection = gst_detection_new(label->str, maxConfScore, bbox);
 
-        g_ptr_array_add(detections, detection);
+// Decode the raw YOLOv5 output, then filter and suppress the detections on the CPU
+static OrtStatusPtr gst_inference_util_decode_yolov5(GstInferenceUtil *self, GstInferenceModel *model, OrtValue **outputs, gint batchIndex, gint batchSize, GPtrArray *out, const char *labelPrefix, GPtrArray *labels, gint targetWidth, gint targetHeight)
+{
+    gfloat *detections;
+    OrtStatusPtr status = self->ort->GetTensorMutableData(outputs[0], (void **)&detections);
+    if (status != NULL)
+        return status;
+
+    detections += batchIndex * EXPECTED_DETECTION_SIZE(model->classCount, model->modelProportion);
+    gfloat *rawDetections = g_malloc(EXPECTED_DETECTION_SIZE(model->classCount, model->modelProportion) * sizeof(gfloat));
+    parse_detections(detections, EXPECTED_DETECTION_COUNT(model->modelProportion), model->classCount, rawDetections);
+    gst_inference_util_postprocess(self, model, rawDetections, out, labelPrefix, labels, targetWidth, targetHeight);
+    g_free(rawDetections);
 
-        g_string_free(label, TRUE);
-        g_free(classProbs);
+    return NULL;
+}
+
+// Decode the transposed anchor-free output [1, 4 + classes, detections] of YOLOv8 style models
+// Boxes are centers and sizes in model input coordinates, the class scores need no weighting by an objectness
+static OrtStatusPtr gst_inference_util_decode_yolov8(GstInferenceUtil *self, GstInferenceModel *model, OrtValue **outputs, gint batchIndex, gint batchSize, GPtrArray *out, const char *labelPrefix, GPtrArray *labels, gint targetWidth, gint targetHeight)
+{
+    const gfloat ratioX = (gfloat)targetWidth / model->modelProportion;
+    const gfloat ratioY = (gfloat)targetHeight / model->modelProportion;
+    const gint count = model->detectionCount;
+
+    gfloat *data;
+    ONNXTensorElementDataType type;
+    size_t elementCount;
+    OrtStatusPtr status = get_tensor(self->ort, outputs[0], (void **)&data, &type, &elementCount);
+    if (status != NULL)
+        return status;
+    if (type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT || elementCount < (size_t)batchSize * (4 + model->classCount) * count)
+        return self->ort->CreateStatus(ORT_INVALID_ARGUMENT, "Unexpected output of anchor-free model");
+    data += (size_t)batchIndex * (4 + model->classCount) * count;
+
+    // Every row holds one value of all detections, so the best class is searched row by row.
+    // The inner loop runs over contiguous memory without branches, which lets the compiler vectorize it.
+    gfloat *maxScores = g_malloc(count * sizeof(gfloat));
+    gint *maxClasses = g_malloc0(count * sizeof(gint));
+    memcpy(maxScores, &data[4 * count], count * sizeof(gfloat));
+    for (gint c = 1; c < model->classCount; c++)
+    {
+        const gfloat *scores = &data[(4 + c) * count];
+        for (gint i = 0; i < count; i++)
+        {
+            gboolean better = scores[i] > maxScores[i];
+            maxScores[i] = better ? scores[i] : maxScores[i];
+            maxClasses[i] = better ? c : maxClasses[i];
+        }
     }
 
-    // Early return for empty detections
-    if (detections->len == 0)
+    // Only few detections pass the threshold, their boxes are gathered from the rows individually
+    GPtrArray *detections = g_ptr_array_new();
+    for (gint i = 0; i < count; i++)
     {
-        goto out;
+        if (maxScores[i] < OBJ_PROB_THRESHOLD)
+            continue;
+
+        gfloat width = data[2 * count + i];
+        gfloat height = data[3 * count + i];
+        BoundingBox bbox = scale_box(data[i] - width / 2.0f, data[count + i] - height / 2.0f, width, height,
+                                     ratioX, ratioY, targetWidth, targetHeight);
+        g_ptr_array_add(detections, new_detection(labelPrefix, labels, maxClasses[i], maxScores[i], bbox));
     }
 
-    // Sort the detections by class to get same classes next one another
-    g_ptr_array_sort(detections, (GCompareFunc)compare_detections);
+    suppress_per_class(detections, out);
+    g_ptr_array_free(detections, FALSE);
+    g_free(maxScores);
+    g_free(maxClasses);
 
-    // Do non maximum suppression per class
-    GPtrArray *group = g_ptr_array_new();
-    const char *currentLabel = ((GstDetection *)g_ptr_array_index(detections, 0))->label;
-    for (gint i = 0; i < detections->len; i++)
+    return NULL;
+}
+
+// Take the detections of a model that runs NMS in its graph, they only need to be scaled and filtered
+// Boxes are given as corners (x1, y1, x2, y2) in model input coordinates
+static OrtStatusPtr gst_inference_util_decode_end_to_end(GstInferenceUtil *self, GstInferenceModel *model, OrtValue **outputs, gint batchIndex, gint batchSize, GPtrArray *out, const char *labelPrefix, GPtrArray *labels, gint targetWidth, gint targetHeight)
+{
+    const gfloat ratioX = (gfloat)targetWidth / model->modelProportion;
+    const gfloat ratioY = (gfloat)targetHeight / model->modelProportion;
+
+    void *data[4];
+    ONNXTensorElementDataType types[4];
+    size_t counts[4];
+    for (gint i = 0; i < 4; i++)
     {
-        GstDetection *element = g_ptr_array_index(detections, i);
+        OrtStatusPtr status = get_tensor(self->ort, outputs[i], &data[i], &types[i], &counts[i]);
+        if (status != NULL)
+            return status;
+    }
 
-        if (!element->label || !currentLabel || g_str_equal(element->label, currentLabel))
-        {
-            // Element still belongs to current class, so transfer it to group
-            g_ptr_array_add(group, g_ptr_array_remove_index(detections, i));
+    // Every frame of the batch has a detection count, the other outputs are padded to a fixed size per frame
+    size_t offsets[4], sizes[4];
+    for (gint i = 0; i < 4; i++)
+    {
+        sizes[i] = counts[i] / batchSize;
+        offsets[i] = batchIndex * sizes[i];
+    }
+    size_t count = sizes[END_TO_END_NUM] ? (size_t)MAX(tensor_value(data[END_TO_END_NUM], types[END_TO_END_NUM], offsets[END_TO_END_NUM]), 0) : 0;
+    count = MIN(count, MIN(sizes[END_TO_END_SCORES], MIN(sizes[END_TO_END_CLASSES], sizes[END_TO_END_BOXES] / 4)));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        gfloat confidence = tensor_value(data[END_TO_END_SCORES], types[END_TO_END_SCORES], offsets[END_TO_END_SCORES] + i);
+        if (confidence < OBJ_PROB_THRESHOLD)
             continue;
+
+        gfloat x1 = tensor_value(data[END_TO_END_BOXES], types[END_TO_END_BOXES], offsets[END_TO_END_BOXES] + i * 4 + 0);
+        gfloat y1 = tensor_value(data[END_TO_END_BOXES], types[END_TO_END_BOXES], offsets[END_TO_END_BOXES] + i * 4 + 1);
+        gfloat x2 = tensor_value(data[END_TO_END_BOXES], types[END_TO_END_BOXES], offsets[END_TO_END_BOXES] + i * 4 + 2);
+        gfloat y2 = tensor_value(data[END_TO_END_BOXES], types[END_TO_END_BOXES], offsets[END_TO_END_BOXES] + i * 4 + 3);
+        gint classIndex = (gint)tensor_value(data[END_TO_END_CLASSES], types[END_TO_END_CLASSES], offsets[END_TO_END_CLASSES] + i);
+
+        BoundingBox bbox = scale_box(x1, y1, x2 - x1, y2 - y1, ratioX, ratioY, targetWidth, targetHeight);
+        g_ptr_array_add(out, new_detection(labelPrefix, labels, classIndex, confidence, bbox));
+    }
+
+    return NULL;
+}
+
+// Turn the outputs for a frame of the batch into detections according to the layout of the model
+static OrtStatusPtr gst_inference_util_decode(GstInferenceUtil *self, GstInferenceModel *model, OrtValue **outputs, gint batchIndex, gint batchSize, GPtrArray *out, const char *labelPrefix, GPtrArray *labels, gint targetWidth, gint targetHeight)
+{
+    switch (model->layout)
+    {
+    case GST_INFERENCE_LAYOUT_YOLOV8:
+        return gst_inference_util_decode_yolov8(self, model, outputs, batchIndex, batchSize, out, labelPrefix, labels, targetWidth, targetHeight);
+    case GST_INFERENCE_LAYOUT_END_TO_END:
+        return gst_inference_util_decode_end_to_end(self, model, outputs, batchIndex, batchSize, out, labelPrefix, labels, targetWidth, targetHeight);
+    case GST_INFERENCE_LAYOUT_CLASSIFIER:
+        return self->ort->CreateStatus(ORT_INVALID_ARGUMENT, "Classifier models can only be used as gate");
+    default:
+        return gst_inference_util_decode_yolov5(self, model, outputs, batchIndex, batchSize, out, labelPrefix, labels, targetWidth, targetHeight);
+    }
+}
+
+// Get a reference on the current model, NULL if none is loaded
+// Lock free, this runs for every inference of every source
+static GstInferenceModel *gst_inference_util_acquire_model(GstInferenceUtil *self)
+{
+    gint reader = g_atomic_int_get(&self->epoch) & 1;
+    g_atomic_int_inc(&self->readers[reader]);
+
+    GstInferenceModel *model = g_atomic_pointer_get(&self->model);
+    if (model)
+        g_atomic_int_inc(&model->refCount);
+
+    // Wake up a swap waiting for this epoch to drain
+    if (g_atomic_int_dec_and_test(&self->readers[reader]) && g_atomic_int_get(&self->swapping))
+    {
+        g_mutex_lock(&self->mtxSwap);
+        g_cond_broadcast(&self->condSwap);
+        g_mutex_unlock(&self->mtxSwap);
+    }
+
+    return model;
+}
+
+static void gst_inference_util_free_model(GstInferenceUtil *self, GstInferenceModel *model);
+
+// Drop a reference on a model, the last user frees it
+static void gst_inference_util_release_model(GstInferenceUtil *self, GstInferenceModel *model)
+{
+    if (model != NULL && g_atomic_int_dec_and_test(&model->refCount))
+        gst_inference_util_free_model(self, model);
+}
+
+// Make the model the one used by new inferences, takes over the reference of the caller
+// Inferences still running on the previous model finish on it, the last of them releases it
+static void gst_inference_util_swap_model(GstInferenceUtil *self, GstInferenceModel *model)
+{
+    g_mutex_lock(&self->mtxSwap);
+
+    GstInferenceModel *previous = g_atomic_pointer_get(&self->model);
+    g_atomic_pointer_set(&self->model, model);
+
+    // Readers that loaded the previous model may not have taken their reference yet. They are registered
+    // in the epoch they started in, which may be older than the current one if they were preempted,
+    // so advance the epoch twice and wait for the readers of both to drain.
+    g_atomic_int_set(&self->swapping, TRUE);
+    for (gint i = 0; i < 2; i++)
+    {
+        gint reader = g_atomic_int_add(&self->epoch, 1) & 1;
+        while (g_atomic_int_get(&self->readers[reader]) > 0)
+            g_cond_wait(&self->condSwap, &self->mtxSwap);
+    }
+    g_atomic_int_set(&self->swapping, FALSE);
+
+    g_mutex_unlock(&self->mtxSwap);
+
+    gst_inference_util_release_model(self, previous);
+}
+
+// Drop the cached detections of the tiles, e.g. when the frame size or the model changed
+static void gst_inference_util_clear_tiles(GstInferenceUtil *self)
+{
+    for (guint i = 0; i < self->tileDetections->len; i++)
+    {
+        GPtrArray *detections = g_ptr_array_index(self->tileDetections, i);
+        if (detections)
+            g_ptr_array_unref(detections);
+    }
+    g_ptr_array_set_size(self->tileDetections, 0);
+    g_array_set_size(self->tiles, 0);
+
+    gst_inference_util_release_model(self, self->tileModel);
+    self->tileModel = NULL;
+}
+
+// Lay out the tiles for the frame, cached detections are only valid for the same layout and model
+static void gst_inference_util_update_tiles(GstInferenceUtil *self, GstInferenceModel *model, gint width, gint height, gfloat overlap)
+{
+    if (self->tileModel == model && self->tileWidth == width && self->tileHeight == height && self->tileOverlap == overlap)
+        return;
+
+    gst_inference_util_clear_tiles(self);
+    g_atomic_int_inc(&model->refCount);
+    self->tileModel = model;
+    self->tileWidth = width;
+    self->tileHeight = height;
+    self->tileOverlap = overlap;
+
+    GArray *columns = tile_positions(width, model->modelProportion, overlap);
+    GArray *rows = tile_positions(height, model->modelProportion, overlap);
+    for (guint row = 0; row < rows->len; row++)
+    {
+        for (guint col = 0; col < columns->len; col++)
+        {
+            Tile tile = {.x = g_array_index(columns, gint, col), .y = g_array_index(rows, gint, row)};
+            g_array_append_val(self->tiles, tile);
         }
+    }
+    g_ptr_array_set_size(self->tileDetections, self->tiles->len); // No detections yet
+
+    g_array_free(columns, TRUE);
+    g_array_free(rows, TRUE);
+}
 
-        // New label at this index, new group starts, so the last group is complete
-        non_max_suppression(group, out);
-        // NMS will remove all elements from the group so we can directly reuse it
+// Detect on model-sized tiles of the full resolution frame as well, so that small content like text is not scaled down.
+// Only tiles with changes are inferred, in batches if the model allows. The others keep their detections.
+// The detections of all tiles and the downscaled frame are merged by NMS across the tiles.
+static OrtStatusPtr gst_inference_util_run_tiles(GstInferenceUtil *self, GstObjDetection *objDet, GstInferenceModel *model, GstBuffer *bypassBuffer, GstVideoMeta *videoMeta, GPtrArray *labels, GPtrArray *detections)
+{
+    const gint proportion = model->modelProportion;
+    OrtStatusPtr status = NULL;
 
-        i = 0;
-        currentLabel = element->label;
+    if (videoMeta->format != GST_VIDEO_FORMAT_BGRA && videoMeta->format != GST_VIDEO_FORMAT_BGRx)
+    {
+        GST_WARNING_OBJECT(objDet, "Tiling needs BGRA frames, got %s", gst_video_format_to_string(videoMeta->format));
+        return NULL;
     }
 
-    // Handle last group (i.e. the remaining detections)
-    non_max_suppression(group, out);
-    g_ptr_array_free(group, FALSE);
+    // The downscaled frame covers small frames already
+    if (videoMeta->width <= proportion && videoMeta->height <= proportion)
+        return NULL;
+
+    gst_inference_util_update_tiles(self, model, videoMeta->width, videoMeta->height, objDet->tileOverlap);
+
+    GstChangeMeta *changeMeta = GST_CHANGE_META_GET(bypassBuffer);
+    GArray *pending = g_array_new(FALSE, FALSE, sizeof(guint));
+    for (guint i = 0; i < self->tiles->len; i++)
+    {
+        if (g_ptr_array_index(self->tileDetections, i) == NULL || tile_changed(changeMeta, &g_array_index(self->tiles, Tile, i), proportion))
+            g_array_append_val(pending, i);
+    }
+    GST_DEBUG_OBJECT(objDet, "Inferring %u of %u tiles", pending->len, self->tiles->len);
+
+    GstMapInfo info;
+    gpointer frame;
+    gint stride;
+    if (!gst_video_meta_map(videoMeta, 0, &info, &frame, &stride, GST_MAP_READ))
+    {
+        g_array_free(pending, TRUE);
+        return self->ort->CreateStatus(ORT_FAIL, "Unable to map frame for tiling");
+    }
+
+    const gint batchLimit = model->dynamicBatch ? MAX_TILE_BATCH : 1;
+    gfloat *processedData = g_malloc(batchLimit * EXPECTED_MODEL_SIZE(proportion) * sizeof(gfloat));
+    for (guint first = 0; first < pending->len; first += batchLimit)
+    {
+        gint batchSize = MIN(batchLimit, pending->len - first);
+        for (gint b = 0; b < batchSize; b++)
+        {
+            Tile *tile = &g_array_index(self->tiles, Tile, g_array_index(pending, guint, first + b));
+            tile_to_float(frame, stride, videoMeta->width, videoMeta->height, tile, proportion, &processedData[b * EXPECTED_MODEL_SIZE(proportion)]);
+        }
+
+        OrtValue *outputs[MAX_OUTPUT_COUNT] = {NULL};
+        gst_inference_util_infer(self, model, &status, processedData, batchSize, outputs);
+        for (gint b = 0; status == NULL && b < batchSize; b++)
+        {
+            guint index = g_array_index(pending, guint, first + b);
+            Tile *tile = &g_array_index(self->tiles, Tile, index);
+
+            GPtrArray *tileDetections = g_ptr_array_new_with_free_func(g_object_unref);
+            status = gst_inference_util_decode(self, model, outputs, b, batchSize, tileDetections, objDet->prefix, labels, proportion, proportion);
+
+            // Move to frame coordinates, tiles at the border may reach beyond the frame
+            for (guint i = 0; i < tileDetections->len; i++)
+            {
+                BoundingBox *bbox = &((GstDetection *)g_ptr_array_index(tileDetections, i))->bbox;
+                bbox->x += tile->x;
+                bbox->y += tile->y;
+                bbox->width = MAX(MIN(bbox->width, videoMeta->width - bbox->x), 0);
+                bbox->height = MAX(MIN(bbox->height, videoMeta->height - bbox->y), 0);
+            }
+
+            if (g_ptr_array_index(self->tileDetections, index))
+                g_ptr_array_unref(g_ptr_array_index(self->tileDetections, index));
+            g_ptr_array_index(self->tileDetections, index) = tileDetections;
+        }
+        gst_inference_util_release_outputs(self, outputs);
+        GOTO_IF(status != NULL, out);
+    }
+
+    // Merge the detections of the downscaled frame and all tiles
+    GPtrArray *candidates = g_ptr_array_new();
+    append_detections(detections, candidates);
+    g_ptr_array_set_size(detections, 0);
+    for (guint i = 0; i < self->tileDetections->len; i++)
+        append_detections(g_ptr_array_index(self->tileDetections, i), candidates);
+
+    suppress_per_class(candidates, detections);
+    g_ptr_array_free(candidates, TRUE);
 
 out:
-    g_ptr_array_free(detections, FALSE);
+    gst_video_meta_unmap(videoMeta, 0, &info);
+    g_free(processedData);
+    g_array_free(pending, TRUE);
+
+    return status;
 }
 
 // Public inference function. Handles all required inference steps
@@ -451,7 +898,8 @@ gboolean gst_inference_util_run_inference(GstInferenceUtil *self, GstObjDetectio
 
     gboolean ret = TRUE;
     OrtStatus *status = NULL;
-    gfloat *processedData = NULL, *rawDetections = NULL;
+    gfloat *processedData = NULL;
+    OrtValue *outputs[MAX_OUTPUT_COUNT] = {NULL};
 
     // Check if initialized & ORT API is available
     if (!self->initialized || self->ort == NULL)
@@ -459,24 +907,29 @@ gboolean gst_inference_util_run_inference(GstInferenceUtil *self, GstObjDetectio
     // Check if bypass buffer is writeable
     g_return_val_if_fail(gst_buffer_is_writable(bypassBuffer), FALSE);
 
+    // Keep the model for the whole inference, even if it gets replaced meanwhile
+    GstInferenceModel *model = gst_inference_util_acquire_model(self);
+    if (model == NULL)
+        return FALSE;
+
     // Check if image from buffer has right size
     GstMapInfo info;
     gst_buffer_map(modelBuffer, &info, GST_MAP_READ);
-    if (info.size != EXPECTED_INPUT_SIZE(self->modelProportion))
+    if (info.size != EXPECTED_INPUT_SIZE(model->modelProportion))
     {
-        GST_ERROR_OBJECT(objDet, "ModelBuffer has wrong size for inference. Got %zu, expected %i", info.size, EXPECTED_INPUT_SIZE(self->modelProportion));
+        GST_ERROR_OBJECT(objDet, "ModelBuffer has wrong size for inference. Got %zu, expected %i", info.size, EXPECTED_INPUT_SIZE(model->modelProportion));
         ret = FALSE;
         goto out;
     }
 
     // Preprocess data
-    processedData = g_malloc(EXPECTED_MODEL_SIZE(self->modelProportion) * sizeof(gfloat));
-    gst_inference_util_preprocess(self, info.data, processedData);
+    processedData = g_malloc(EXPECTED_MODEL_SIZE(model->modelProportion) * sizeof(gfloat));
+    gst_inference_util_preprocess(self, model, info.data, processedData);
     GST_DEBUG_OBJECT(objDet, "Finished preprocessing");
 
     // Run inference
-    rawDetections = g_malloc(EXPECTED_DETECTION_SIZE(self->classCount, self->modelProportion) * sizeof(gfloat));
-    gst_inference_util_infer(self, &status, processedData, rawDetections);
+    gst_inference_util_infer(self, model, &status, processedData, 1, outputs);
+    GOTO_IF(status != NULL, out);
     GST_DEBUG_OBJECT(objDet, "Finished infering");
 
     // Get information on bypass buffer
@@ -489,7 +942,21 @@ gboolean gst_inference_util_run_inference(GstInferenceUtil *self, GstObjDetectio
     }
 
     // Postprocess the output (automatically adds detections to the metadata)
-    gst_inference_util_postprocess(self, rawDetections, data->detections, objDet->prefix, objDet->labels, videoMeta->width, videoMeta->height);
+    // Labels of the model take precedence over the ones configured on the element
+    GPtrArray *labels;
+    if (model->labels->len)
+        labels = g_ptr_array_ref(model->labels);
+    else
+    {
+        GST_OBJECT_LOCK(objDet);
+        labels = g_ptr_array_copy(objDet->labels, (GCopyFunc)g_strdup, NULL);
+        g_ptr_array_set_free_func(labels, g_free);
+        GST_OBJECT_UNLOCK(objDet);
+    }
+    status = gst_inference_util_decode(self, model, outputs, 0, 1, data->detections, objDet->prefix, labels, videoMeta->width, videoMeta->height);
+    if (status == NULL && objDet->tiling)
+        status = gst_inference_util_run_tiles(self, objDet, model, bypassBuffer, videoMeta, labels, data->detections);
+    g_ptr_array_unref(labels);
     GST_DEBUG_OBJECT(objDet, "Finished postprocess");
 
 out:
@@ -505,64 +972,275 @@ out:
     gst_buffer_unmap(modelBuffer, &info);
     if (processedData)
         g_free(processedData);
-    if (rawDetections)
-        g_free(rawDetections);
+    gst_inference_util_release_outputs(self, outputs);
+
+    gst_inference_util_release_model(self, model);
 
     GST_DEBUG_OBJECT(objDet, "Finished inference");
     return ret;
 }
 
-// Create an onnxruntime session
-static OrtStatusPtr gst_inference_util_create_session(GstInferenceUtil *self, GstObjDetection *objDet)
+// Run the gate model on the frame of the detector to get the likelihood of sensitive content
+// Classifiers give it as class score, with class 0 being the background if there are several classes.
+// Detectors give it as confidence of their best detection.
+gboolean gst_inference_util_run_gate(GstInferenceUtil *self, GstObjDetection *objDet, GstBuffer *modelBuffer, gfloat *score)
 {
-    OrtStatusPtr status;
-#ifdef WIN32
-    int wcharCharacterCount = MultiByteToWideChar(CP_UTF8, 0, objDet->modelPath, -1, NULL, 0);
-    wchar_t *wideModelPath = g_malloc(wcharCharacterCount * sizeof(wchar_t));
-    MultiByteToWideChar(CP_UTF8, 0, objDet->modelPath, -1, wideModelPath, wcharCharacterCount);
-    status = self->ort->CreateSession(self->environment, wideModelPath, self->options, &self->session);
-    g_free((void *)wideModelPath);
-#else
-    status = self->ort->CreateSession(self->environment, objDet->modelPath, self->options, &self->session);
-#endif
-
-    // Early return on error
-    GOTO_IF(status != NULL, out);
-
-    OrtTypeInfo *typeInfo = NULL;
-    const OrtTensorTypeAndShapeInfo *tensorInfo = NULL;
-    size_t dimCount;
-    gint64 *dimensions;
+    gboolean ret = TRUE;
+    OrtStatus *status = NULL;
+    guint8 *scaledData = NULL;
+    gfloat *processedData = NULL;
+    OrtValue *outputs[MAX_OUTPUT_COUNT] = {NULL};
+    GPtrArray *detections = NULL;
 
-    // Get model width/height
-    // Get input tensor and retrieve its info
-    status = self->ort->SessionGetInputTypeInfo(self->session, 0, &typeInfo);
-    GOTO_IF(status != NULL, out);
+    *score = 0;
 
-    status = self->ort->CastTypeInfoToTensorInfo(typeInfo, &tensorInfo); // No need to free tensorInfo
-    GOTO_IF(status != NULL, out);
+    // Check if initialized & ORT API is available
+    if (!self->initialized || self->ort == NULL)
+        return FALSE;
 
-    status = self->ort->GetDimensionsCount(tensorInfo, &dimCount);
-    GOTO_IF(status != NULL, out);
+    GstInferenceModel *model = gst_inference_util_acquire_model(self);
+    if (model == NULL)
+        return FALSE;
 
-    dimensions = g_malloc(dimCount * sizeof(gint64));
-    status = self->ort->GetDimensions(tensorInfo, dimensions, dimCount);
-    GOTO_IF(status != NULL, out);
+    // The frame has the input size of the detector
+    GstMapInfo info;
+    gst_buffer_map(modelBuffer, &info, GST_MAP_READ);
+    gint frameProportion = (gint)sqrt(info.size / INPUT_CHANNELS);
+    if (info.size != EXPECTED_INPUT_SIZE(frameProportion))
+    {
+        GST_ERROR_OBJECT(objDet, "ModelBuffer is no square frame, got %zu bytes", info.size);
+        ret = FALSE;
+        goto out;
+    }
 
-    // Get last element dimension (i.e. model width/height)
-    self->modelProportion = (gint)dimensions[dimCount - 1];
-    gst_obj_detection_reconfigure_model_sink(objDet, self->modelProportion);
+    guint8 *frameData = info.data;
+    if (frameProportion != model->modelProportion)
+    {
+        scaledData = scale_frame(info.data, frameProportion, model->modelProportion);
+        frameData = scaledData;
+    }
 
-    // Free memory
-    g_free((void *)dimensions);
-    self->ort->ReleaseTypeInfo(typeInfo);
+    processedData = g_malloc(EXPECTED_MODEL_SIZE(model->modelProportion) * sizeof(gfloat));
+    gst_inference_util_preprocess(self, model, frameData, processedData);
 
-    // Get class count
-    // Get output tensor and retrieve its info
-    status = self->ort->SessionGetOutputTypeInfo(self->session, 0, &typeInfo);
+    gst_inference_util_infer(self, model, &status, processedData, 1, outputs);
     GOTO_IF(status != NULL, out);
 
-    status = self->ort->CastTypeInfoToTensorInfo(typeInfo, &tensorInfo); // No need to free tensorInfo
+    if (model->layout == GST_INFERENCE_LAYOUT_CLASSIFIER)
+    {
+        gfloat *scores;
+        status = self->ort->GetTensorMutableData(outputs[0], (void **)&scores);
+        GOTO_IF(status != NULL, out);
+
+        for (gint i = model->classCount > 1 ? 1 : 0; i < model->classCount; i++)
+            *score = MAX(*score, scores[i]);
+    }
+    else
+    {
+        // Labels do not matter, the detections are dropped right away
+        GPtrArray *labels = g_ptr_array_new();
+        detections = g_ptr_array_new_with_free_func(g_object_unref);
+        status = gst_inference_util_decode(self, model, outputs, 0, 1, detections, "gate", labels, model->modelProportion, model->modelProportion);
+        g_ptr_array_unref(labels);
+        GOTO_IF(status != NULL, out);
+
+        for (gint i = 0; i < detections->len; i++)
+            *score = MAX(*score, ((GstDetection *)g_ptr_array_index(detections, i))->confidence);
+    }
+
+    GST_DEBUG_OBJECT(objDet, "Gate score %f", *score);
+
+out:
+    if (status != NULL)
+    {
+        const char *errMessage = self->ort->GetErrorMessage(status);
+        GST_ERROR_OBJECT(objDet, "%s", errMessage);
+
+        ret = FALSE;
+        self->ort->ReleaseStatus(status);
+    }
+
+    gst_buffer_unmap(modelBuffer, &info);
+    g_free(scaledData);
+    g_free(processedData);
+    if (detections)
+        g_ptr_array_unref(detections);
+    gst_inference_util_release_outputs(self, outputs);
+
+    gst_inference_util_release_model(self, model);
+
+    return ret;
+}
+
+// Get the session for the model, either from the shared sessions or by creating a new one
+// Sessions are only shared between elements using the same execution provider and session settings
+static OrtStatusPtr gst_inference_util_acquire_session(GstInferenceUtil *self, const char *modelPath, const char *sessionKey, OrtSession **session, gboolean *warm)
+{
+    OrtStatusPtr status = NULL;
+    *warm = FALSE;
+
+    g_mutex_lock(&mtxSharedSessions);
+
+    if (sharedSessions == NULL)
+        sharedSessions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    SharedSession *shared = g_hash_table_lookup(sharedSessions, sessionKey);
+    if (shared != NULL)
+    {
+        shared->refCount++;
+        *session = shared->session;
+        *warm = shared->warm;
+        goto out;
+    }
+
+#ifdef WIN32
+    int wcharCharacterCount = MultiByteToWideChar(CP_UTF8, 0, modelPath, -1, NULL, 0);
+    wchar_t *wideModelPath = g_malloc(wcharCharacterCount * sizeof(wchar_t));
+    MultiByteToWideChar(CP_UTF8, 0, modelPath, -1, wideModelPath, wcharCharacterCount);
+    status = self->ort->CreateSession(self->environment, wideModelPath, self->options, session);
+    g_free((void *)wideModelPath);
+#else
+    status = self->ort->CreateSession(self->environment, modelPath, self->options, session);
+#endif
+    GOTO_IF(status != NULL, out);
+
+    shared = g_new(SharedSession, 1);
+    shared->session = *session;
+    shared->refCount = 1;
+    shared->warm = FALSE;
+    g_hash_table_insert(sharedSessions, g_strdup(sessionKey), shared);
+
+out:
+    g_mutex_unlock(&mtxSharedSessions);
+
+    return status;
+}
+
+// Write the trace of a session and post a summary of the most expensive operators
+static void gst_inference_util_end_profiling(GstInferenceUtil *self, OrtSession *session)
+{
+    OrtStatus *status = NULL;
+    OrtAllocator *allocator = NULL;
+    char *profilePath = NULL;
+
+    status = self->ort->GetAllocatorWithDefaultOptions(&allocator); // No need to free allocator
+    GOTO_IF(status != NULL, out);
+
+    status = self->ort->SessionEndProfiling(session, allocator, &profilePath);
+    GOTO_IF(status != NULL, out);
+
+    GST_INFO_OBJECT(self->element, "Wrote inference profile to %s", profilePath);
+
+    GstStructure *summary = inference_profile_summarize(profilePath, PROFILE_HOTSPOT_COUNT);
+    if (summary)
+        gst_element_post_message(self->element, gst_message_new_element(GST_OBJECT(self->element), summary));
+    else
+        GST_WARNING_OBJECT(self->element, "Unable to read inference profile %s", profilePath);
+
+    allocator->Free(allocator, profilePath);
+
+out:
+    if (status != NULL)
+    {
+        const char *errMessage = self->ort->GetErrorMessage(status);
+        GST_ERROR_OBJECT(self->element, "%s", errMessage);
+
+        self->ort->ReleaseStatus(status);
+    }
+}
+
+// Remember that the session has been warmed up, so that other users of it can skip their warm-up
+static void gst_inference_util_set_session_warm(GstInferenceUtil *self, const gchar *sessionKey)
+{
+    g_mutex_lock(&mtxSharedSessions);
+
+    SharedSession *shared = g_hash_table_lookup(sharedSessions, sessionKey);
+    if (shared != NULL)
+        shared->warm = TRUE;
+
+    g_mutex_unlock(&mtxSharedSessions);
+}
+
+// Drop the reference on the session, the last user releases it
+static void gst_inference_util_release_session(GstInferenceUtil *self, const gchar *sessionKey)
+{
+    OrtSession *session = NULL;
+
+    g_mutex_lock(&mtxSharedSessions);
+
+    SharedSession *shared = g_hash_table_lookup(sharedSessions, sessionKey);
+    if (shared != NULL && --shared->refCount == 0)
+    {
+        session = shared->session;
+        g_hash_table_remove(sharedSessions, sessionKey);
+    }
+
+    g_mutex_unlock(&mtxSharedSessions);
+
+    if (session == NULL)
+        return;
+
+    // Profiled sessions belong to this util alone. Their trace is written once the last model using them is gone,
+    // so that models replaced at runtime keep their trace as well.
+    if (self->profiling)
+        gst_inference_util_end_profiling(self, session);
+
+    self->ort->ReleaseSession(session);
+}
+
+static void gst_inference_util_free_model(GstInferenceUtil *self, GstInferenceModel *model)
+{
+    if (model->sessionKey)
+        gst_inference_util_release_session(self, model->sessionKey);
+
+    g_free(model->sessionKey);
+    g_free(model->modelPath);
+    g_free(model->inputName);
+    g_strfreev(model->outputNames);
+    g_ptr_array_unref(model->labels);
+    g_free(model);
+}
+
+// Run inferences on a blank frame. Onnxruntime allocates its buffers and selects kernels on the first runs,
+// which makes them several times slower than the following ones.
+static OrtStatusPtr gst_inference_util_warm_up(GstInferenceUtil *self, GstInferenceModel *model, guint runs)
+{
+    OrtStatusPtr status = NULL;
+    gfloat *processedData = g_malloc0(EXPECTED_MODEL_SIZE(model->modelProportion) * sizeof(gfloat));
+    OrtValue *outputs[MAX_OUTPUT_COUNT] = {NULL};
+
+    for (guint i = 0; i < runs; i++)
+    {
+        GstClockTime begin = gst_util_get_timestamp();
+        gst_inference_util_infer(self, model, &status, processedData, 1, outputs);
+        gst_inference_util_release_outputs(self, outputs);
+        GOTO_IF(status != NULL, out);
+
+        model->lastRunTime = gst_util_get_timestamp() - begin;
+        if (i == 0)
+            model->firstRunTime = model->lastRunTime;
+        model->warmupRuns++;
+    }
+
+out:
+    g_free(processedData);
+
+    return status;
+}
+
+// Tell the raw layouts apart by the shape of the output and get the number of classes
+// YOLOv5 outputs [1, detections, 5 + classes], YOLOv8 style models output [1, 4 + classes, detections] without objectness
+static OrtStatusPtr gst_inference_util_read_raw_layout(GstInferenceUtil *self, GstInferenceModel *model, size_t output)
+{
+    OrtTypeInfo *typeInfo = NULL;
+    const OrtTensorTypeAndShapeInfo *tensorInfo = NULL;
+    gint64 *dimensions = NULL;
+    size_t dimCount;
+
+    OrtStatusPtr status = self->ort->SessionGetOutputTypeInfo(model->session, output, &typeInfo);
+    GOTO_IF(status != NULL, out);
+
+    status = self->ort->CastTypeInfoToTensorInfo(typeInfo, &tensorInfo); // No need to free tensorInfo
     GOTO_IF(status != NULL, out);
 
     status = self->ort->GetDimensionsCount(tensorInfo, &dimCount);
@@ -572,27 +1250,182 @@ static OrtStatusPtr gst_inference_util_create_session(GstInferenceUtil *self, Gs
     status = self->ort->GetDimensions(tensorInfo, dimensions, dimCount);
     GOTO_IF(status != NULL, out);
 
+    // Class scores [1, classes] of a classifier, only used as gate
+    if (dimCount == 2)
+    {
+        model->layout = GST_INFERENCE_LAYOUT_CLASSIFIER;
+        model->classCount = (gint)dimensions[1];
+        model->detectionCount = 0;
+        goto out;
+    }
+
+    // There are always far more detections than classes
+    if (dimCount == 3 && dimensions[1] > 4 && (dimensions[2] < 0 || dimensions[1] < dimensions[2]))
+    {
+        model->layout = GST_INFERENCE_LAYOUT_YOLOV8;
+        model->classCount = (gint)dimensions[1] - 4;
+        model->detectionCount = dimensions[2] > 0 ? (gint)dimensions[2] : ANCHOR_FREE_DETECTION_COUNT(model->modelProportion);
+        goto out;
+    }
+
     // Get last element dimension (i.e. detection size)
     gint fullDetectionSize = (gint)dimensions[dimCount - 1];
-    self->classCount = fullDetectionSize - 5;
+    model->layout = GST_INFERENCE_LAYOUT_YOLOV5;
+    model->classCount = fullDetectionSize - 5;
+    model->detectionCount = EXPECTED_DETECTION_COUNT(model->modelProportion);
 
-    // Free memory
+out:
     g_free((void *)dimensions);
-    self->ort->ReleaseTypeInfo(typeInfo);
+    if (typeInfo)
+        self->ort->ReleaseTypeInfo(typeInfo);
 
-    // Get label names from meta
-    OrtModelMetadata *modelMeta = NULL;
-    status = self->ort->SessionGetModelMetadata(self->session, &modelMeta);
+    return status;
+}
+
+// Detect the output layout of the model from the names of its outputs and select the outputs to request
+static OrtStatusPtr gst_inference_util_read_layout(GstInferenceUtil *self, GstInferenceModel *model, OrtAllocator *allocator)
+{
+    // Substrings identifying the outputs of end-to-end models, e.g. num_dets, det_boxes, det_scores and det_classes
+    static const char *endToEndKeys[] = {"num", "box", "score", "class"};
+    gint endToEndOutputs[] = {-1, -1, -1, -1};
+
+    size_t count;
+    gchar **names = NULL;
+    OrtStatusPtr status = self->ort->SessionGetOutputCount(model->session, &count);
+    GOTO_IF(status != NULL, out);
+
+    names = g_new0(gchar *, count + 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        char *name;
+        status = self->ort->SessionGetOutputName(model->session, i, allocator, &name);
+        GOTO_IF(status != NULL, out);
+        names[i] = g_ascii_strdown(name, -1);
+        allocator->Free(allocator, name);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        for (gint key = 0; key < G_N_ELEMENTS(endToEndKeys); key++)
+        {
+            if (endToEndOutputs[key] < 0 && strstr(names[i], endToEndKeys[key]))
+            {
+                endToEndOutputs[key] = i;
+                break;
+            }
+        }
+    }
+
+    // Names of the outputs are needed in their original case for running the session
+    if (endToEndOutputs[0] >= 0 && endToEndOutputs[1] >= 0 && endToEndOutputs[2] >= 0 && endToEndOutputs[3] >= 0)
+    {
+        model->layout = GST_INFERENCE_LAYOUT_END_TO_END;
+        model->outputCount = 4;
+        model->classCount = -1; // Not needed, classes are given as indices
+    }
+    else
+    {
+        // Combined raw output (e.g. 25200 x (5 + classes) for 640x640), the model may have additional per-scale outputs
+        model->outputCount = 1;
+        endToEndOutputs[0] = 0;
+
+        status = gst_inference_util_read_raw_layout(self, model, 0);
+        GOTO_IF(status != NULL, out);
+    }
+
+    model->outputNames = g_new0(gchar *, model->outputCount + 1);
+    for (guint i = 0; i < model->outputCount; i++)
+    {
+        char *name;
+        status = self->ort->SessionGetOutputName(model->session, endToEndOutputs[i], allocator, &name);
+        GOTO_IF(status != NULL, out);
+        model->outputNames[i] = g_strdup(name);
+        allocator->Free(allocator, name);
+    }
+
+out:
+    g_strfreev(names);
+
+    return status;
+}
+
+// Load a model, i.e. get its onnxruntime session and read its dimensions and labels
+static OrtStatusPtr gst_inference_util_create_model(GstInferenceUtil *self, const char *modelPath, guint warmupRuns, GstInferenceModel **out)
+{
+    GstInferenceModel *model = g_new0(GstInferenceModel, 1);
+    model->refCount = 1;
+    model->labels = g_ptr_array_new_with_free_func(g_free);
+
+    model->modelPath = g_strdup(modelPath);
+
+    GstClockTime begin = gst_util_get_timestamp();
+    guint64 residentBefore = 0, residentAfter = 0, peak;
+    gboolean memoryAvailable = process_memory_get(&residentBefore, &peak);
+
+    OrtStatusPtr status;
+    // Profiled sessions are not shared, so that their traces only contain the inferences of this element
+    gchar *sessionKey;
+    if (self->profiling)
+        sessionKey = g_strdup_printf("%s:%p:%s", self->optionsKey, self, modelPath);
+    else
+        sessionKey = g_strdup_printf("%s:%s", self->optionsKey, modelPath);
+    gboolean warm;
+    status = gst_inference_util_acquire_session(self, modelPath, sessionKey, &model->session, &warm);
+
+    // Early return on error
+    if (status != NULL)
+    {
+        g_free(sessionKey);
+        goto out;
+    }
+    model->sessionKey = sessionKey;
+
+    OrtTypeInfo *typeInfo = NULL;
+    const OrtTensorTypeAndShapeInfo *tensorInfo = NULL;
+    size_t dimCount;
+    gint64 *dimensions;
+
+    // Get model width/height
+    // Get input tensor and retrieve its info
+    status = self->ort->SessionGetInputTypeInfo(model->session, 0, &typeInfo);
+    GOTO_IF(status != NULL, out);
+
+    status = self->ort->CastTypeInfoToTensorInfo(typeInfo, &tensorInfo); // No need to free tensorInfo
+    GOTO_IF(status != NULL, out);
+
+    status = self->ort->GetDimensionsCount(tensorInfo, &dimCount);
+    GOTO_IF(status != NULL, out);
+
+    dimensions = g_malloc(dimCount * sizeof(gint64));
+    status = self->ort->GetDimensions(tensorInfo, dimensions, dimCount);
     GOTO_IF(status != NULL, out);
 
-    // Retrieve custom metadata
+    // Get last element dimension (i.e. model width/height)
+    model->modelProportion = (gint)dimensions[dimCount - 1];
+    model->dynamicBatch = dimCount == 4 && dimensions[0] < 0;
+
+    // Free memory
+    g_free((void *)dimensions);
+    self->ort->ReleaseTypeInfo(typeInfo);
+
     OrtAllocator *allocator = NULL;
     status = self->ort->GetAllocatorWithDefaultOptions(&allocator); // No need to free allocator
     GOTO_IF(status != NULL, out);
 
-    // Clear existing labels
-    while (objDet->labels->len)
-        g_ptr_array_remove_index(objDet->labels, 0);
+    char *inputName;
+    status = self->ort->SessionGetInputName(model->session, 0, allocator, &inputName);
+    GOTO_IF(status != NULL, out);
+    model->inputName = g_strdup(inputName);
+    allocator->Free(allocator, inputName);
+
+    // Find out how the model reports its detections
+    status = gst_inference_util_read_layout(self, model, allocator);
+    GOTO_IF(status != NULL, out);
+
+    // Get label names from meta
+    OrtModelMetadata *modelMeta = NULL;
+    status = self->ort->SessionGetModelMetadata(model->session, &modelMeta);
+    GOTO_IF(status != NULL, out);
 
     char *labelString;
     status = self->ort->ModelMetadataLookupCustomMetadataMap(modelMeta, allocator, "labels", &labelString);
@@ -605,7 +1438,7 @@ static OrtStatusPtr gst_inference_util_create_session(GstInferenceUtil *self, Gs
         for (gint i = 0; labels[i]; i++)
         {
             char *label = labels[i];
-            g_ptr_array_add(objDet->labels, g_strdup(label));
+            g_ptr_array_add(model->labels, g_strdup(label));
         }
         g_strfreev(labels);
     }
@@ -614,10 +1447,325 @@ static OrtStatusPtr gst_inference_util_create_session(GstInferenceUtil *self, Gs
     self->ort->ReleaseModelMetadata(modelMeta);
     allocator->Free(allocator, labelString);
 
+    model->loadTime = gst_util_get_timestamp() - begin;
+
+    // A session taken over from another element has already allocated its buffers
+    if (!warm && warmupRuns > 0)
+    {
+        status = gst_inference_util_warm_up(self, model, warmupRuns);
+        GOTO_IF(status != NULL, out);
+        gst_inference_util_set_session_warm(self, model->sessionKey);
+    }
+
+    // After the warm-up the arena holds the buffers of a full inference
+    if (memoryAvailable && process_memory_get(&residentAfter, &peak) && residentAfter > residentBefore)
+        model->memoryGrowth = residentAfter - residentBefore;
+
 out:
+    if (status != NULL)
+    {
+        gst_inference_util_free_model(self, model);
+        model = NULL;
+    }
+
+    *out = model;
     return status;
 }
 
+// Let the element know about the dimensions and labels of the model and report how long loading took
+// The gate model takes the frames of the detector as they are and has no labels to show
+static void gst_inference_util_apply_model(GstInferenceUtil *self, GstObjDetection *objDet, GstInferenceModel *model)
+{
+    if (!self->gate)
+    {
+        gst_obj_detection_reconfigure_model_sink(objDet, model->modelProportion);
+        gst_obj_detection_update_labels(objDet, model->labels);
+    }
+
+    GST_INFO_OBJECT(objDet, "Using %s%s model %s on %s, loaded in %" GST_TIME_FORMAT ", %u warm-up runs (first %" GST_TIME_FORMAT ", last %" GST_TIME_FORMAT "), process memory grew by %" G_GUINT64_FORMAT " kB",
+                    self->gate ? "gate " : "", gst_inference_layout_get_name(model->layout), model->modelPath, gst_inference_provider_get_name(self->provider), GST_TIME_ARGS(model->loadTime), model->warmupRuns,
+                    GST_TIME_ARGS(model->firstRunTime), GST_TIME_ARGS(model->lastRunTime), model->memoryGrowth / 1024);
+
+    GstStructure *structure = gst_structure_new(GST_INFERENCE_MODEL_LOADED_NAME,
+                                                "model", G_TYPE_STRING, model->modelPath,
+                                                "gate", G_TYPE_BOOLEAN, self->gate,
+                                                "execution-provider", G_TYPE_STRING, gst_inference_provider_get_name(self->provider),
+                                                "layout", G_TYPE_STRING, gst_inference_layout_get_name(model->layout),
+                                                "load-time", G_TYPE_UINT64, model->loadTime,
+                                                "warmup-runs", G_TYPE_UINT, model->warmupRuns,
+                                                "first-run", G_TYPE_UINT64, model->firstRunTime,
+                                                "last-run", G_TYPE_UINT64, model->lastRunTime,
+                                                "process-memory-growth-at-load", G_TYPE_UINT64, model->memoryGrowth,
+                                                NULL);
+    gst_element_post_message(GST_ELEMENT(objDet), gst_message_new_element(GST_OBJECT(objDet), structure));
+}
+
+// Model requested by a reinitialization
+typedef struct _LoadRequest LoadRequest;
+struct _LoadRequest
+{
+    GstObjDetection *objDet;
+    gchar *modelPath;
+    guint warmupRuns;
+    gint generation;
+};
+
+// Load a model on the loader thread while the current model keeps serving, then switch over
+static void gst_inference_util_load(LoadRequest *request, GstInferenceUtil *self)
+{
+    GstInferenceModel *model = NULL;
+    OrtStatus *status = NULL;
+
+    // Skip models that have been superseded while waiting
+    if (request->generation != g_atomic_int_get(&self->loadGeneration))
+        goto out;
+
+    GST_DEBUG_OBJECT(request->objDet, "Loading model %s", request->modelPath);
+
+    status = gst_inference_util_create_model(self, request->modelPath, request->warmupRuns, &model);
+    GOTO_IF(status != NULL, out);
+
+    if (request->generation != g_atomic_int_get(&self->loadGeneration))
+        goto out;
+
+    gst_inference_util_swap_model(self, model);
+    gst_inference_util_apply_model(self, request->objDet, model);
+    model = NULL; // Reference taken over by the swap
+
+out:
+    if (status != NULL)
+    {
+        // The previous model stays in use
+        const char *errMessage = self->ort->GetErrorMessage(status);
+        GST_ERROR_OBJECT(request->objDet, "%s", errMessage);
+
+        self->ort->ReleaseStatus(status);
+    }
+
+    gst_inference_util_release_model(self, model);
+
+    g_object_unref(request->objDet);
+    g_free(request->modelPath);
+    g_free(request);
+}
+
+// Name onnxruntime reports for an execution provider
+const char *gst_inference_provider_get_name(GstInferenceProvider provider)
+{
+    switch (provider)
+    {
+    case GST_INFERENCE_PROVIDER_DNNL:
+        return "DnnlExecutionProvider";
+    case GST_INFERENCE_PROVIDER_XNNPACK:
+        return "XnnpackExecutionProvider";
+    default:
+        return "CPUExecutionProvider";
+    }
+}
+
+const char *gst_inference_layout_get_name(GstInferenceLayout layout)
+{
+    switch (layout)
+    {
+    case GST_INFERENCE_LAYOUT_YOLOV8:
+        return "yolov8";
+    case GST_INFERENCE_LAYOUT_END_TO_END:
+        return "end-to-end";
+    case GST_INFERENCE_LAYOUT_CLASSIFIER:
+        return "classifier";
+    default:
+        return "yolov5";
+    }
+}
+
+// Check whether the linked onnxruntime has been built with the execution provider
+static gboolean gst_inference_util_provider_available(GstInferenceUtil *self, GstInferenceProvider provider)
+{
+    char **providers;
+    int count;
+    gboolean available = FALSE;
+
+    OrtStatus *status = self->ort->GetAvailableProviders(&providers, &count);
+    if (status != NULL)
+    {
+        self->ort->ReleaseStatus(status);
+        return FALSE;
+    }
+
+    for (gint i = 0; i < count; i++)
+        available |= g_str_equal(providers[i], gst_inference_provider_get_name(provider));
+
+    self->ort->ReleaseAvailableProviders(providers, count);
+
+    return available;
+}
+
+// Register the execution provider on the session options
+// Falls back to the default CPU provider if it is unavailable, returns the provider actually used
+static GstInferenceProvider gst_inference_util_append_provider(GstInferenceUtil *self, GstObjDetection *objDet, GstInferenceProvider provider)
+{
+    OrtStatus *status = NULL;
+
+    if (provider == GST_INFERENCE_PROVIDER_DEFAULT)
+        return provider;
+
+    if (!gst_inference_util_provider_available(self, provider))
+    {
+        GST_WARNING_OBJECT(objDet, "%s not available in this onnxruntime build, using the default provider", gst_inference_provider_get_name(provider));
+        return GST_INFERENCE_PROVIDER_DEFAULT;
+    }
+
+    switch (provider)
+    {
+    case GST_INFERENCE_PROVIDER_DNNL:
+    {
+#if ORT_API_VERSION >= 15
+        OrtDnnlProviderOptions *dnnlOptions;
+        status = self->ort->CreateDnnlProviderOptions(&dnnlOptions);
+        GOTO_IF(status != NULL, out);
+        status = self->ort->SessionOptionsAppendExecutionProvider_Dnnl(self->options, dnnlOptions);
+        self->ort->ReleaseDnnlProviderOptions(dnnlOptions);
+#else
+        GST_WARNING_OBJECT(objDet, "Built against an onnxruntime without oneDNN support, using the default provider");
+        return GST_INFERENCE_PROVIDER_DEFAULT;
+#endif
+    }
+    break;
+    case GST_INFERENCE_PROVIDER_XNNPACK:
+    {
+#if ORT_API_VERSION >= 12
+        // XNNPACK runs its own thread pool, onnxruntime recommends to not spin up a second one for the remaining nodes
+        gchar *threadCount = g_strdup_printf("%d", INFERENCE_THREAD_COUNT);
+        const char *keys[] = {"intra_op_num_threads"};
+        const char *values[] = {threadCount};
+        status = self->ort->SessionOptionsAppendExecutionProvider(self->options, "XNNPACK", keys, values, 1);
+        g_free(threadCount);
+        GOTO_IF(status != NULL, out);
+
+        status = self->ort->SetIntraOpNumThreads(self->options, 1);
+        GOTO_IF(status != NULL, out);
+        status = self->ort->AddSessionConfigEntry(self->options, "session.intra_op.allow_spinning", "0");
+#else
+        GST_WARNING_OBJECT(objDet, "Built against an onnxruntime without XNNPACK support, using the default provider");
+        return GST_INFERENCE_PROVIDER_DEFAULT;
+#endif
+    }
+    break;
+    default:
+        break;
+    }
+
+out:
+    if (status != NULL)
+    {
+        GST_WARNING_OBJECT(objDet, "Unable to use %s, using the default provider: %s", gst_inference_provider_get_name(provider), self->ort->GetErrorMessage(status));
+        self->ort->ReleaseStatus(status);
+        return GST_INFERENCE_PROVIDER_DEFAULT;
+    }
+
+    return provider;
+}
+
+// Let onnxruntime record the execution time of every node of the sessions
+static OrtStatusPtr gst_inference_util_enable_profiling(GstInferenceUtil *self, GstObjDetection *objDet)
+{
+    const gchar *directory = objDet->profilingDir;
+    if (directory == NULL)
+        directory = g_getenv(PROFILING_DIR_ENV);
+    if (directory == NULL)
+        directory = g_get_tmp_dir();
+
+    // Onnxruntime appends a timestamp to this prefix
+    gchar *fileName = g_strdup_printf("%s-%sprofile", GST_OBJECT_NAME(objDet), self->gate ? "gate-" : "");
+    gchar *prefix = g_build_filename(directory, fileName, NULL);
+    g_free(fileName);
+
+    GST_INFO_OBJECT(objDet, "Profiling inference to %s", prefix);
+
+#ifdef WIN32
+    int wcharCharacterCount = MultiByteToWideChar(CP_UTF8, 0, prefix, -1, NULL, 0);
+    wchar_t *widePrefix = g_malloc(wcharCharacterCount * sizeof(wchar_t));
+    MultiByteToWideChar(CP_UTF8, 0, prefix, -1, widePrefix, wcharCharacterCount);
+    OrtStatusPtr status = self->ort->EnableProfiling(self->options, widePrefix);
+    g_free((void *)widePrefix);
+#else
+    OrtStatusPtr status = self->ort->EnableProfiling(self->options, prefix);
+#endif
+    g_free(prefix);
+
+    return status;
+}
+
+// Apply the memory settings of the element to the session and run options
+static OrtStatusPtr gst_inference_util_configure_memory(GstInferenceUtil *self, GstObjDetection *objDet)
+{
+    OrtStatusPtr status = NULL;
+    OrtMemoryInfo *memoryInfo = NULL;
+    OrtArenaCfg *arenaConfig = NULL;
+
+    // Reusing the buffers of the previous run only pays off for fixed input sizes
+    if (objDet->memoryPattern)
+        status = self->ort->EnableMemPattern(self->options);
+    else
+        status = self->ort->DisableMemPattern(self->options);
+    GOTO_IF(status != NULL, out);
+
+    if (!objDet->memoryArena)
+    {
+        status = self->ort->DisableCpuMemArena(self->options);
+        goto out;
+    }
+
+    status = self->ort->EnableCpuMemArena(self->options);
+    GOTO_IF(status != NULL, out);
+
+    // Sessions grow their own arena in powers of two. Other strategies need an arena registered on the environment,
+    // which is shared by all sessions of the process. The first element to register it determines its settings.
+    if (objDet->arenaExtendStrategy != GST_INFERENCE_ARENA_EXTEND_POWER_OF_TWO)
+    {
+        const char *keys[] = {"arena_extend_strategy"};
+        const size_t values[] = {1}; // kSameAsRequested
+        status = self->ort->CreateArenaCfgV2(keys, values, 1, &arenaConfig);
+        GOTO_IF(status != NULL, out);
+
+        status = self->ort->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &memoryInfo);
+        GOTO_IF(status != NULL, out);
+
+        status = self->ort->CreateAndRegisterAllocator(self->environment, memoryInfo, arenaConfig);
+        if (status != NULL)
+        {
+            GST_DEBUG_OBJECT(objDet, "Using the arena already registered: %s", self->ort->GetErrorMessage(status));
+            self->ort->ReleaseStatus(status);
+        }
+
+        status = self->ort->AddSessionConfigEntry(self->options, "session.use_env_allocators", "1");
+        GOTO_IF(status != NULL, out);
+    }
+
+    // Return unused memory of the arena after every inference
+    if (objDet->arenaShrinkage)
+    {
+        status = self->ort->CreateRunOptions(&self->runOptions);
+        GOTO_IF(status != NULL, out);
+        status = self->ort->AddRunConfigEntry(self->runOptions, "memory.enable_memory_arena_shrinkage", "cpu:0");
+        GOTO_IF(status != NULL, out);
+    }
+
+out:
+    if (arenaConfig)
+        self->ort->ReleaseArenaCfg(arenaConfig);
+    if (memoryInfo)
+        self->ort->ReleaseMemoryInfo(memoryInfo);
+
+    return status;
+}
+
+// Model the element configured for this inference
+static const char *gst_inference_util_get_model_path(GstInferenceUtil *self, GstObjDetection *objDet)
+{
+    return self->gate ? objDet->gateModelPath : objDet->modelPath;
+}
+
 // Actual inference initialization
 void gst_inference_util_initialize(GstInferenceUtil *self, GstObjDetection *objDet)
 {
@@ -633,7 +1781,8 @@ void gst_inference_util_initialize(GstInferenceUtil *self, GstObjDetection *objD
         return;
     }
 
-    if (objDet->modelPath == NULL)
+    const char *modelPath = gst_inference_util_get_model_path(self, objDet);
+    if (modelPath == NULL)
     {
         GST_WARNING("Model path undefined, aborting initialization");
         return;
@@ -641,6 +1790,7 @@ void gst_inference_util_initialize(GstInferenceUtil *self, GstObjDetection *objD
 
     OrtStatus *status = NULL;
     gboolean ret = TRUE;
+    GstInferenceModel *model = NULL;
 
     // Setup session
     status = self->ort->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "objdetection", &self->environment);
@@ -651,11 +1801,33 @@ void gst_inference_util_initialize(GstInferenceUtil *self, GstObjDetection *objD
     GOTO_IF(status != NULL, out);
     status = self->ort->SetSessionGraphOptimizationLevel(self->options, ORT_ENABLE_ALL);
     GOTO_IF(status != NULL, out);
+    self->provider = gst_inference_util_append_provider(self, objDet, objDet->executionProvider);
+    status = gst_inference_util_configure_memory(self, objDet);
+    GOTO_IF(status != NULL, out);
+
+    // The run options (arena shrinkage) are per util and don't matter for sharing
+    g_free(self->optionsKey);
+    self->optionsKey = g_strdup_printf("%s:threads=%d:arena=%d:pattern=%d:extend=%d", gst_inference_provider_get_name(self->provider), INFERENCE_THREAD_COUNT,
+                                       objDet->memoryArena, objDet->memoryPattern, objDet->arenaExtendStrategy);
+
+    self->element = GST_ELEMENT(objDet);
+    self->profiling = objDet->profiling || g_getenv(PROFILING_DIR_ENV) != NULL;
+    if (self->profiling)
+    {
+        status = gst_inference_util_enable_profiling(self, objDet);
+        GOTO_IF(status != NULL, out);
+    }
 
     // Create session
-    status = gst_inference_util_create_session(self, objDet);
+    status = gst_inference_util_create_model(self, modelPath, objDet->warmupRuns, &model);
     GOTO_IF(status != NULL, out);
 
+    gst_inference_util_swap_model(self, model);
+    gst_inference_util_apply_model(self, objDet, model);
+
+    // A single loader thread, so that model changes are applied in order
+    self->loader = g_thread_pool_new((GFunc)gst_inference_util_load, self, 1, FALSE, NULL);
+
 out:
     if (status != NULL)
     {
@@ -670,6 +1842,7 @@ out:
 }
 
 // Updates the used onnxmodel
+// The new model is loaded in the background, inference continues with the current model until it is ready
 void gst_inference_util_reinitialize(GstInferenceUtil *self, GstObjDetection *objDet)
 {
     if (!self->initialized)
@@ -679,43 +1852,33 @@ void gst_inference_util_reinitialize(GstInferenceUtil *self, GstObjDetection *ob
         return;
     }
 
-    OrtStatus *status = NULL;
-    gboolean ret = TRUE;
-
-    // Block inference threads
-    g_mutex_lock(&self->mtxBlocked);
-    self->sessionBlocked = TRUE;
-    g_mutex_unlock(&self->mtxBlocked);
-
-    // Wait until inference threads are all blocked
-    g_mutex_lock(&self->mtxRefCount);
-    while (self->sessionRefCount > 0)
-        g_cond_wait(&self->condRefCount, &self->mtxRefCount);
-    g_mutex_unlock(&self->mtxRefCount);
-
-    // Release old session
-    self->ort->ReleaseSession(self->session);
+    const char *modelPath = gst_inference_util_get_model_path(self, objDet);
+    if (modelPath == NULL)
+    {
+        GST_WARNING("Model path undefined, keeping current model");
+        return;
+    }
 
-    // Create new session
-    status = gst_inference_util_create_session(self, objDet);
-    GOTO_IF(status != NULL, out);
+    LoadRequest *request = g_new(LoadRequest, 1);
+    request->objDet = g_object_ref(objDet);
+    request->modelPath = g_strdup(modelPath);
+    request->warmupRuns = objDet->warmupRuns;
+    request->generation = g_atomic_int_add(&self->loadGeneration, 1) + 1;
 
-    g_mutex_lock(&self->mtxBlocked);
-    self->sessionBlocked = FALSE;
-    g_cond_signal(&self->condBlocked); // Signal potentially waiting infer threads
-    g_mutex_unlock(&self->mtxBlocked);
+    g_thread_pool_push(self->loader, request, NULL);
+}
 
-out:
-    if (status != NULL)
-    {
-        const char *errMessage = self->ort->GetErrorMessage(status);
-        GST_ERROR("%s", errMessage);
+// Growth of the process memory while the current model was loaded, 0 if unknown
+guint64 gst_inference_util_get_memory_growth_at_load(GstInferenceUtil *self)
+{
+    GstInferenceModel *model = gst_inference_util_acquire_model(self);
+    if (model == NULL)
+        return 0;
 
-        ret = FALSE;
-        self->ort->ReleaseStatus(status);
-    }
+    guint64 memoryGrowth = model->memoryGrowth;
+    gst_inference_util_release_model(self, model);
 
-    self->initialized = ret;
+    return memoryGrowth;
 }
 
 void gst_inference_util_finalize(GstInferenceUtil *self)
@@ -726,23 +1889,22 @@ void gst_inference_util_finalize(GstInferenceUtil *self)
         return;
     }
 
-    g_mutex_lock(&self->mtxRefCount);
-    while (self->sessionRefCount > 0)
-        g_cond_wait(&self->condRefCount, &self->mtxRefCount);
-    g_mutex_unlock(&self->mtxRefCount);
+    // Drop pending model loads and wait for the running one
+    g_atomic_int_inc(&self->loadGeneration);
+    g_thread_pool_free(self->loader, FALSE, TRUE);
+    self->loader = NULL;
 
     // Dispose of the model and interpreter objects
     // Close ONNX session
-    self->ort->ReleaseSession(self->session);
+    gst_inference_util_clear_tiles(self);
+    gst_inference_util_swap_model(self, NULL);
     self->ort->ReleaseSessionOptions(self->options);
+    if (self->runOptions)
+        self->ort->ReleaseRunOptions(self->runOptions);
+    self->runOptions = NULL;
     self->ort->ReleaseEnv(self->environment);
-
-    // Clean session variables
-    self->classCount = -1;
-
-    // Reset thread management
-    self->sessionRefCount = 0;
-    self->sessionBlocked = FALSE;
+    g_free(self->optionsKey);
+    self->optionsKey = NULL;
 
     self->initialized = FALSE;
 }
@@ -753,15 +1915,27 @@ static void gst_inference_util_init(GstInferenceUtil *self)
     // Set default values
     self->initialized = FALSE;
     self->ort = NULL;
-
-    g_mutex_init(&self->mtxBlocked);
-    g_mutex_init(&self->mtxRefCount);
-
-    g_cond_init(&self->condBlocked);
-    g_cond_init(&self->condRefCount);
-
-    self->sessionRefCount = 0;
-    self->sessionBlocked = FALSE;
+    self->model = NULL;
+    self->loader = NULL;
+    self->loadGeneration = 0;
+    self->provider = GST_INFERENCE_PROVIDER_DEFAULT;
+    self->profiling = FALSE;
+    self->runOptions = NULL;
+    self->optionsKey = NULL;
+    self->element = NULL;
+    self->gate = FALSE;
+
+    self->tiles = g_array_new(FALSE, FALSE, sizeof(Tile));
+    self->tileDetections = g_ptr_array_new();
+    self->tileModel = NULL;
+    self->tileWidth = self->tileHeight = 0;
+    self->tileOverlap = 0;
+
+    self->epoch = 0;
+    self->readers[0] = self->readers[1] = 0;
+    self->swapping = FALSE;
+    g_mutex_init(&self->mtxSwap);
+    g_cond_init(&self->condSwap);
 
 // Initialize onnxruntime API
 #ifdef WIN32
@@ -823,11 +1997,12 @@ static void gst_inference_util_object_finalize(GObject *object)
     // Default session finalization
     gst_inference_util_finalize(self);
 
+    g_array_free(self->tiles, TRUE);
+    g_ptr_array_free(self->tileDetections, TRUE);
+
     // Reset thread management
-    g_mutex_clear(&self->mtxBlocked);
-    g_mutex_clear(&self->mtxRefCount);
-    g_cond_clear(&self->condBlocked);
-    g_cond_clear(&self->condRefCount);
+    g_mutex_clear(&self->mtxSwap);
+    g_cond_clear(&self->condSwap);
 
 #ifdef WIN32
     // Onnxruntime management
@@ -848,3 +2023,12 @@ GstInferenceUtil *gst_inference_util_new()
 {
     return g_object_new(GST_TYPE_INFERENCE_UTIL, NULL);
 }
+
+// Inference for the gate model of the element, which decides whether the detector needs to run
+GstInferenceUtil *gst_inference_util_new_gate()
+{
+    GstInferenceUtil *self = g_object_new(GST_TYPE_INFERENCE_UTIL, NULL);
+    self->gate = TRUE;
+
+    return self;
+}
@@ -3,6 +3,22 @@
 typedef struct _GstInferenceUtil GstInferenceUtil;
 typedef struct _GstInferenceUtilClass GstInferenceUtilClass;
 
+// Defined before the includes, the detection element uses it as well
+typedef enum _GstInferenceProvider GstInferenceProvider;
+enum _GstInferenceProvider
+{
+    GST_INFERENCE_PROVIDER_DEFAULT, // Default CPU provider of onnxruntime
+    GST_INFERENCE_PROVIDER_DNNL,    // oneDNN
+    GST_INFERENCE_PROVIDER_XNNPACK, // XNNPACK
+};
+
+typedef enum _GstInferenceArenaExtend GstInferenceArenaExtend;
+enum _GstInferenceArenaExtend
+{
+    GST_INFERENCE_ARENA_EXTEND_POWER_OF_TWO,      // Each session grows its arena in powers of two (onnxruntime default)
+    GST_INFERENCE_ARENA_EXTEND_SAME_AS_REQUESTED, // Arena shared by all sessions, grown by the requested size only
+};
+
 #include "inferencedata.h"
 #include "gstobjdetection.h"
 #include <gst/gst.h>
@@ -22,24 +38,79 @@ G_BEGIN_DECLS
 
 GType gst_inference_util_get_type(void) G_GNUC_CONST;
 
+#define GST_INFERENCE_MODEL_LOADED_NAME "sps-model-loaded" // Element message posted when a model is put to use
+
+// How a model reports its detections
+typedef enum _GstInferenceLayout GstInferenceLayout;
+enum _GstInferenceLayout
+{
+    GST_INFERENCE_LAYOUT_YOLOV5,     // Single output [1, detections, 5 + classes], NMS runs on the CPU
+    GST_INFERENCE_LAYOUT_YOLOV8,     // Anchor-free transposed output [1, 4 + classes, detections] without objectness
+    GST_INFERENCE_LAYOUT_END_TO_END, // NMS in the graph, outputs for the detection count, boxes, scores and classes
+    GST_INFERENCE_LAYOUT_CLASSIFIER, // Class scores [1, classes], only for gate models
+};
+
+// A loaded model and everything derived from it. Immutable once created, freed when the last user drops it.
+typedef struct _GstInferenceModel GstInferenceModel;
+struct _GstInferenceModel
+{
+    gint refCount; // Updated atomically
+
+    OrtSession *session;
+    gchar *sessionKey; // Key of the session in the shared session table
+    gchar *modelPath;
+
+    GstInferenceLayout layout;
+    gchar *inputName;
+    gchar **outputNames; // Outputs requested from the session, in the order the layout reads them
+    guint outputCount;
+
+    gint classCount;     // Only known for the raw layouts
+    gint detectionCount; // Detections per inference of the raw layouts
+    gint modelProportion;
+    gboolean dynamicBatch; // Whether several frames can be inferred at once
+    GPtrArray *labels;     // Labels from the model metadata
+
+    GstClockTime loadTime;                  // Time to create the session and read the model info
+    guint warmupRuns;                       // Inferences run on a blank frame before the model was used
+    GstClockTime firstRunTime, lastRunTime; // Duration of the first and last warm-up inference
+    guint64 memoryGrowth;                   // Growth of the process resident memory while loading and warming up in
+                                            // bytes, about 0 for shared sessions and not attributable to the model alone
+};
+
 struct _GstInferenceUtil
 {
     GObject parent;
 
     gboolean initialized;
 
-    guint sessionRefCount;
-    gboolean sessionBlocked;
-    GMutex mtxRefCount, mtxBlocked;
-    GCond condRefCount, condBlocked;
+    // Model used for new inferences. Inferences take their reference without locking, they only register in
+    // the counter of the current epoch while doing so. Swaps wait for these counters (see swap_model).
+    GstInferenceModel *model;
+    gint epoch, readers[2];
+    gboolean swapping;
+    GMutex mtxSwap; // Serializes swaps
+    GCond condSwap; // Signaled by the last reader of an epoch during a swap
+
+    GThreadPool *loader; // Loads models in the background on reinitialization
+    gint loadGeneration; // Incremented on every requested model, superseded loads are dropped
 
     const OrtApi *ort;
     OrtEnv *environment;
     OrtSessionOptions *options;
-    OrtSession *session;
+    OrtRunOptions *runOptions; // NULL for the defaults
+    gchar *optionsKey;         // Every setting the sessions are created with, sessions are only shared on equal settings
+    GstInferenceProvider provider; // Execution provider the sessions actually use
+    gboolean profiling;            // Whether onnxruntime records a trace of the sessions
+    GstElement *element;           // Element the util belongs to, receives the profile summaries
+    gboolean gate;                 // Runs the gate model of the element instead of its detector
 
-    gint classCount;
-    gint modelProportion;
+    // Tiles of the full resolution frame and their detections of the last inference, only used on the streaming thread
+    GArray *tiles;                 // Tile
+    GPtrArray *tileDetections;     // Detections per tile, NULL until a tile has been inferred
+    GstInferenceModel *tileModel;  // Model the tile detections stem from, referenced
+    gint tileWidth, tileHeight;    // Frame size the tiles were laid out for
+    gfloat tileOverlap;
 
 #ifdef WIN32
     GModule *module;
@@ -56,10 +127,15 @@ G_END_DECLS
 // Helpers
 void inference_couple(GstInferenceData *source, GstInferenceData *target);
 gboolean inference_apply(GstObjDetection *objDet, GstBuffer *bypassBuffer, GstInferenceData *data);
+const char *gst_inference_provider_get_name(GstInferenceProvider provider);
+const char *gst_inference_layout_get_name(GstInferenceLayout layout);
 
 // Methods
 void gst_inference_util_initialize(GstInferenceUtil *self, GstObjDetection *objDet);
 void gst_inference_util_reinitialize(GstInferenceUtil *self, GstObjDetection *objDet);
+guint64 gst_inference_util_get_memory_growth_at_load(GstInferenceUtil *self);
 void gst_inference_util_finalize(GstInferenceUtil *self);
 gboolean gst_inference_util_run_inference(GstInferenceUtil *self, GstObjDetection *objDet, GstBuffer *modelBuffer, GstBuffer *bypassBuffer, GstInferenceData *data);
+gboolean gst_inference_util_run_gate(GstInferenceUtil *self, GstObjDetection *objDet, GstBuffer *modelBuffer, gfloat *score);
 GstInferenceUtil *gst_inference_util_new();
+GstInferenceUtil *gst_inference_util_new_gate();
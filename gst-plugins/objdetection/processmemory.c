@@ -0,0 +1,62 @@
+#include "processmemory.h"
+
+#ifdef WIN32
+#include <Windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <stdio.h>
+#endif
+
+gboolean process_memory_get(guint64 *resident, guint64 *peak)
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return FALSE;
+
+    *resident = counters.WorkingSetSize;
+    *peak = counters.PeakWorkingSetSize;
+    return TRUE;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return FALSE;
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return FALSE;
+
+    *resident = info.resident_size;
+    *peak = usage.ru_maxrss; // Bytes on macOS
+    return TRUE;
+#else
+    // Values in kB
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status == NULL)
+        return FALSE;
+
+    gboolean foundResident = FALSE, foundPeak = FALSE;
+    char line[256];
+    while (fgets(line, sizeof(line), status))
+    {
+        unsigned long long value;
+        if (sscanf(line, "VmRSS: %llu kB", &value) == 1)
+        {
+            *resident = value * 1024;
+            foundResident = TRUE;
+        }
+        else if (sscanf(line, "VmHWM: %llu kB", &value) == 1)
+        {
+            *peak = value * 1024;
+            foundPeak = TRUE;
+        }
+    }
+    fclose(status);
+
+    return foundResident && foundPeak;
+#endif
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// Resident memory of the process and its peak so far in bytes. Returns FALSE if unavailable on this platform.
+gboolean process_memory_get(guint64 *resident, guint64 *peak);
+
+G_END_DECLS
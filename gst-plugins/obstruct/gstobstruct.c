@@ -19,10 +19,14 @@
 #include "gstobstruct.h"
 #include "obstruct.h"
 #include <detectionmeta.h>
+#include <changemeta.h>
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
 
+#define DEFAULT_STRENGTH 96   // Blur radius resp. pixelation block size in pixels
+#define DEFAULT_THREAD_COUNT 0 // Use all processors
+
 GST_DEBUG_CATEGORY(gst_obstruct_debug);
 
 enum
@@ -33,6 +37,9 @@ enum
   PROP_MARGIN,
   PROP_ACTIVE,
   PROP_INVERT,
+  PROP_STRENGTH,
+  PROP_THREAD_COUNT,
+  PROP_STATS,
 };
 
 // TODO: Possibly allow more formats in the future
@@ -62,7 +69,9 @@ static void gst_obstruct_set_property(GObject *object, guint prop_id, const GVal
   }
   break;
   case PROP_FILTER_TYPE:
+    GST_OBJECT_LOCK(filter);
     filter->filterType = g_value_get_uint(value);
+    GST_OBJECT_UNLOCK(filter);
     break;
   case PROP_MARGIN:
     filter->margin = g_value_get_float(value);
@@ -73,6 +82,16 @@ static void gst_obstruct_set_property(GObject *object, guint prop_id, const GVal
   case PROP_INVERT:
     filter->invert = g_value_get_boolean(value);
     break;
+  case PROP_STRENGTH:
+    GST_OBJECT_LOCK(filter);
+    filter->strength = g_value_get_uint(value);
+    GST_OBJECT_UNLOCK(filter);
+    break;
+  case PROP_THREAD_COUNT:
+    // The workers serialize the pool change with a running frame themselves
+    filter->threadCount = g_value_get_uint(value);
+    obstruct_workers_set_thread_count(filter->workers, filter->threadCount);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     break;
@@ -115,6 +134,15 @@ static void gst_obstruct_get_property(GObject *object, guint prop_id, GValue *va
   case PROP_INVERT:
     g_value_set_boolean(value, filter->invert);
     break;
+  case PROP_STRENGTH:
+    g_value_set_uint(value, filter->strength);
+    break;
+  case PROP_THREAD_COUNT:
+    g_value_set_uint(value, filter->threadCount);
+    break;
+  case PROP_STATS:
+    g_value_take_boxed(value, gst_processing_stats_get_structure(filter->stats));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     break;
@@ -143,6 +171,17 @@ static gboolean gst_obstruct_stop(GstObstruct *filter)
   return TRUE;
 }
 
+// Handle events travelling upstream
+static gboolean gst_obstruct_src_event(GstBaseTransform *base, GstEvent *event)
+{
+  GstObstruct *filter = GST_OBSTRUCT(base);
+
+  if (GST_EVENT_TYPE(event) == GST_EVENT_QOS)
+    gst_qos_tracker_update(filter->qos, event);
+
+  return GST_BASE_TRANSFORM_CLASS(parent_class)->src_event(base, event);
+}
+
 // Handle incoming buffer
 static GstFlowReturn gst_obstruct_transform_buffer(GstBaseTransform *base, GstBuffer *buffer)
 {
@@ -150,13 +189,14 @@ static GstFlowReturn gst_obstruct_transform_buffer(GstBaseTransform *base, GstBu
   GstDetectionMeta *detectionMeta;
   GstVideoMeta *videoMeta;
   GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime begin = gst_processing_stats_begin();
 
   GST_DEBUG_OBJECT(filter, "Received buffer");
 
   if (!filter->active)
   {
     GST_DEBUG_OBJECT(filter, "Filter disabled, no processing");
-    goto out;
+    goto skip;
   }
 
   detectionMeta = GST_DETECTION_META_GET(buffer);
@@ -164,7 +204,7 @@ static GstFlowReturn gst_obstruct_transform_buffer(GstBaseTransform *base, GstBu
   {
     // Ignore buffer
     GST_ERROR_OBJECT(filter, "No object detection meta on the buffer");
-    goto out;
+    goto skip;
   }
 
   videoMeta = (GstVideoMeta *)gst_buffer_get_meta(buffer, GST_VIDEO_META_API_TYPE);
@@ -172,25 +212,22 @@ static GstFlowReturn gst_obstruct_transform_buffer(GstBaseTransform *base, GstBu
   {
     // Ignore buffer
     GST_ERROR_OBJECT(filter, "No video meta on the buffer");
-    goto out;
+    goto skip;
   }
 
-  GstMapInfo info;
-  gst_buffer_map(buffer, &info, GST_MAP_READWRITE);
-
+  // Collect the regions of all matching detections
+  GArray *regions = g_array_new(FALSE, FALSE, sizeof(BoundingBox));
+  GList *labels = g_hash_table_get_values(filter->labels);
   for (gint i = 0; i < detectionMeta->detections->len; i++)
   {
     GstDetection *detection = g_ptr_array_index(detectionMeta->detections, i);
 
-    GList *labels = g_hash_table_get_values(filter->labels);
     gboolean match = FALSE;
-    while(labels != NULL)
+    for (GList *label = labels; label != NULL; label = label->next)
     {
-      match = g_str_has_prefix(detection->label, labels->data);
+      match = g_str_has_prefix(detection->label, label->data);
       if (match)
         break;
-
-      labels = labels->next;
     }
 
     if (!filter->invert && !match || filter->invert && match)
@@ -198,19 +235,58 @@ static GstFlowReturn gst_obstruct_transform_buffer(GstBaseTransform *base, GstBu
 
     GST_DEBUG_OBJECT(filter, "Found detection to process: %s", detection->label);
 
-    // Apply filter on detection
-    if (!apply_filter(videoMeta, info.data, detection, filter->filterType, filter->margin))
-    {
-      GST_ERROR_OBJECT(filter, "Error applying filter");
-      ret = GST_FLOW_ERROR;
-      goto unmap;
-    }
+    BoundingBox region = {
+        .x = (gint)(detection->bbox.x + filter->margin),
+        .y = (gint)(detection->bbox.y + filter->margin),
+        .width = (gint)(detection->bbox.width - 2 * filter->margin),
+        .height = (gint)(detection->bbox.height - 2 * filter->margin),
+    };
+    g_array_append_val(regions, region);
+  }
+  g_list_free(labels);
+
+  if (regions->len == 0)
+  {
+    obstruct_cache_clear(filter->cache);
+    goto free_regions;
+  }
+
+  // Take the settings of this frame, the filter itself runs without holding the object lock
+  GST_OBJECT_LOCK(filter);
+  FilterType filterType = filter->filterType;
+  guint strength = filter->strength;
+  ObstructWorkers *workers = filter->workers;
+  GST_OBJECT_UNLOCK(filter);
+
+  // Late frames are never dropped, as that would stall the output, but filled instead of blurred
+  GstClockTime runningTime = gst_segment_to_running_time(&base->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+  if ((filterType == FILTER_TYPE_BLUR || filterType == FILTER_TYPE_PIXELATE) && gst_qos_tracker_is_late(filter->qos, runningTime))
+  {
+    GST_DEBUG_OBJECT(filter, "Buffer is late, using cheaper filter");
+    filterType = FILTER_TYPE_BLACK;
+  }
+
+  GstMapInfo info;
+  gst_buffer_map(buffer, &info, GST_MAP_READWRITE);
+
+  // Apply filter on all regions in a single pass
+  if (!apply_filter(videoMeta, info.data, regions, filterType, strength, filter->cache, GST_CHANGE_META_GET(buffer), GST_BUFFER_PTS(buffer), workers))
+  {
+    GST_ERROR_OBJECT(filter, "Error applying filter");
+    ret = GST_FLOW_ERROR;
   }
 
-unmap:
   gst_buffer_unmap(buffer, &info);
 
-out:
+free_regions:
+  g_array_free(regions, TRUE);
+  gst_processing_stats_end(filter->stats, begin);
+  return ret;
+
+skip:
+  // Cached regions are only valid for consecutive processed frames
+  obstruct_cache_clear(filter->cache);
+  gst_processing_stats_end(filter->stats, begin);
   return ret;
 }
 
@@ -224,8 +300,17 @@ static void gst_obstruct_init(GstObstruct *filter)
                                          NULL);       // Value will be destructed by the key destructor
 
   filter->filterType = FILTER_TYPE_BLUR;
+  filter->strength = DEFAULT_STRENGTH;
   filter->active = TRUE;
   filter->invert = FALSE;
+
+  filter->threadCount = DEFAULT_THREAD_COUNT;
+
+  filter->cache = obstruct_cache_new();
+  filter->workers = obstruct_workers_new(filter->threadCount);
+
+  filter->stats = gst_processing_stats_new(GST_ELEMENT(filter));
+  filter->qos = gst_qos_tracker_new();
 }
 
 // Object destructor -> called if an object gets destroyed
@@ -234,6 +319,10 @@ static void gst_obstruct_finalize(GObject *object)
   GstObstruct *filter = GST_OBSTRUCT(object);
 
   g_hash_table_destroy(filter->labels);
+  obstruct_cache_free(filter->cache);
+  obstruct_workers_free(filter->workers);
+  gst_processing_stats_free(filter->stats);
+  gst_qos_tracker_free(filter->qos);
 
   G_OBJECT_CLASS(gst_obstruct_parent_class)->finalize(object);
 }
@@ -283,12 +372,27 @@ static void gst_obstruct_class_init(GstObstructClass *klass)
                                                     FILTER_TYPE_BLUR,
                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property(gobject_class, PROP_STRENGTH,
+                                  g_param_spec_uint("strength", "Strength",
+                                                    "Blur radius or pixelation block size in pixels",
+                                                    1, 4096,
+                                                    DEFAULT_STRENGTH,
+                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(gobject_class, PROP_THREAD_COUNT,
+                                  g_param_spec_uint("thread-count", "Thread count",
+                                                    "Number of threads the regions are processed on, at most the number of processors (0 = number of processors)",
+                                                    0, 256,
+                                                    DEFAULT_THREAD_COUNT,
+                                                    G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property(gobject_class, PROP_MARGIN,
                                   g_param_spec_float("margin", "Margin",
                                                      "How much margin around the detection should be masked too",
                                                      -FLT_MAX, FLT_MAX,
                                                      0,
                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property(gobject_class, PROP_STATS, gst_processing_stats_param_spec());
 
   // Set plugin metadata
   gst_element_class_set_static_metadata(gstelement_class,
@@ -303,6 +407,7 @@ static void gst_obstruct_class_init(GstObstructClass *klass)
 
   // Set function pointers to implementation of base class
   gstbasetransform_class->transform_ip = GST_DEBUG_FUNCPTR(gst_obstruct_transform_buffer);
+  gstbasetransform_class->src_event = GST_DEBUG_FUNCPTR(gst_obstruct_src_event);
 }
 
 // Plugin initializer that registers the plugin
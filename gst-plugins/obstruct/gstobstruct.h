@@ -2,6 +2,8 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <processingstats.h>
+#include <qostracker.h>
 #include "obstruct.h"
 
 G_BEGIN_DECLS
@@ -23,9 +25,17 @@ struct _GstObstruct
 
   GHashTable *labels;
   FilterType filterType;
+  guint strength;
   gfloat margin;
   gboolean invert;
   gboolean active;
+  guint threadCount;
+
+  GstProcessingStats *stats;
+  GstQosTracker *qos;
+
+  ObstructCache *cache;
+  ObstructWorkers *workers;
 };
 
 struct _GstObstructClass
@@ -1,42 +1,166 @@
-
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include "obstruct.h"
+#include "privacyfilter.h"
+#include <map>
+#include <tuple>
+#include <vector>
+#include <cstring>
 
 extern "C"
 {
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <detectionmeta.h>
+#include <changemeta.h>
 }
 
+#define DOWNSCALE_MIN_REGION_SIZE 256  // Regions with smaller sides are blurred at full resolution
+#define DOWNSCALE_TARGET_RADIUS 4      // Blur radius that remains after downscaling
+#define BAND_MIN_PIXELS (256 * 256)    // Fills and pixelation of smaller regions are not split into bands
+#define CACHE_MAX_AGE 30               // Frames a cached region is reused before it is filtered again
+
 using namespace cv;
 
-gboolean apply_filter(GstVideoMeta *meta, guint8 *data, GstDetection *detection, FilterType filterType, gfloat margin)
+typedef std::tuple<gint, gint, gint, gint> CacheKey; // x, y, width, height of a region
+
+// Filtered pixels of a region and the number of frames they have been reused for
+struct CacheEntry
 {
-    Mat frame;
+    std::vector<guint8> pixels;
+    guint age;
+};
 
-    // Create Mat from the raw data
-    switch (meta->format)
+struct _ObstructWorkers
+{
+    GMutex mtxWorkers; // Guards the pool while a frame is distributed on it
+    GThreadPool *pool;
+    guint threadCount;
+
+    GMutex mtxPending;
+    GCond condPending;
+    guint pending;
+};
+
+// A single region processed by one worker
+struct FilterJob
+{
+    ObstructWorkers *workers;
+    Mat *frame;
+    guint8 *data;
+    gsize stride;
+    BoundingBox bbox;
+    FilterType filterType;
+    guint strength;
+    gboolean ret;
+};
+
+struct _ObstructCache
+{
+    FilterType filterType;
+    guint strength;
+    guint width, height;
+    GstClockTime pts; // PTS of the frame the entries were taken from
+
+    std::map<CacheKey, CacheEntry> entries;
+};
+
+ObstructCache *obstruct_cache_new()
+{
+    ObstructCache *cache = new ObstructCache();
+    cache->filterType = FILTER_TYPE_BLACK;
+    cache->strength = 0;
+    cache->width = 0;
+    cache->height = 0;
+    cache->pts = GST_CLOCK_TIME_NONE;
+
+    return cache;
+}
+
+void obstruct_cache_clear(ObstructCache *cache)
+{
+    cache->entries.clear();
+    cache->pts = GST_CLOCK_TIME_NONE;
+}
+
+void obstruct_cache_free(ObstructCache *cache)
+{
+    delete cache;
+}
+
+// Copies the pixels of a region between the frame and a contiguous buffer
+static void copy_region(guint8 *data, gsize stride, BoundingBox *bbox, guint8 *buffer, gboolean toFrame)
+{
+    const gsize rowSize = (gsize)bbox->width * PRIVACY_FILTER_CHANNELS;
+    guint8 *origin = data + bbox->y * stride + (gsize)bbox->x * PRIVACY_FILTER_CHANNELS;
+
+    for (gint y = 0; y < bbox->height; y++)
     {
-    case GST_VIDEO_FORMAT_BGRA:
-        frame = Mat(meta->height, meta->width, CV_8UC4, data);
-        break;
-    default:
-        GST_DEBUG("Unsupported video format");
+        if (toFrame)
+            memcpy(origin + y * stride, buffer + y * rowSize, rowSize);
+        else
+            memcpy(buffer + y * rowSize, origin + y * stride, rowSize);
+    }
+}
+
+// Checks whether the content below a region is unchanged compared to the frame the cache was filled from
+static gboolean region_unchanged(BoundingBox *bbox, GstChangeMeta *changeMeta, ObstructCache *cache)
+{
+    // Without change information we have to assume a change
+    if (!changeMeta)
         return FALSE;
+
+    // Frames dropped between the change detector and this element make the change information relative to a
+    // frame the cache has never seen
+    if (!GST_CLOCK_TIME_IS_VALID(cache->pts) || changeMeta->referencePts != cache->pts)
+        return FALSE;
+
+    if (!changeMeta->changed)
+        return TRUE;
+
+    for (guint i = 0; i < changeMeta->regions->len; i++)
+    {
+        if (gst_bounding_box_do_intersect(bbox, &g_array_index(changeMeta->regions, BoundingBox, i)))
+            return FALSE;
     }
 
-    // Region to be filtered
-    Rect region = Rect(detection->bbox.x + margin, detection->bbox.y + margin, detection->bbox.width - 2 * margin, detection->bbox.height - 2 * margin);
-    region = region & cv::Rect(0, 0, meta->width, meta->height);
-    if (region.width == 0 || region.height == 0)
+    return TRUE;
+}
+
+// Blurs large regions at a reduced resolution and scales the result back up into the frame.
+// As the output is meant to be unreadable, this is visually equivalent to a full resolution blur.
+static void blur_region(Mat &frame, guint8 *data, gsize stride, BoundingBox *bbox, guint strength)
+{
+    gint factor = strength / DOWNSCALE_TARGET_RADIUS;
+    if (factor < 2 || MIN(bbox->width, bbox->height) < DOWNSCALE_MIN_REGION_SIZE)
     {
-        GST_DEBUG("Invalid region");
-        return TRUE; // Don't abort stream
+        privacy_filter_box_blur(data, stride, bbox, strength, PRIVACY_FILTER_GAUSSIAN_PASSES);
+        return;
     }
 
-    // Apply filter effect in place
+    Rect region = Rect(bbox->x, bbox->y, bbox->width, bbox->height);
+    Size smallSize = Size((region.width + factor - 1) / factor, (region.height + factor - 1) / factor);
+
+    Mat small;
+    resize(frame(region), small, smallSize, 0, 0, INTER_AREA);
+
+    BoundingBox smallBox = {
+        .x = 0,
+        .y = 0,
+        .width = small.cols,
+        .height = small.rows,
+    };
+    privacy_filter_box_blur(small.data, small.step, &smallBox, DOWNSCALE_TARGET_RADIUS, PRIVACY_FILTER_GAUSSIAN_PASSES);
+
+    // Destination has matching size and type, so the result is written directly into the frame
+    Mat target = frame(region);
+    resize(small, target, region.size(), 0, 0, INTER_LINEAR);
+}
+
+static gboolean filter_region(Mat &frame, guint8 *data, gsize stride, BoundingBox *bbox, FilterType filterType, guint strength)
+{
+    Rect region = Rect(bbox->x, bbox->y, bbox->width, bbox->height);
+
     switch (filterType)
     {
     case FILTER_TYPE_BLACK:
@@ -46,11 +170,10 @@ gboolean apply_filter(GstVideoMeta *meta, guint8 *data, GstDetection *detection,
         frame(region).setTo(Scalar(255, 255, 255, 255));
         break;
     case FILTER_TYPE_BLUR:
-        cv::blur(
-            frame(region),
-            frame(region),
-            Size(320, 320)
-        );
+        blur_region(frame, data, stride, bbox, strength);
+        break;
+    case FILTER_TYPE_PIXELATE:
+        privacy_filter_pixelate(data, stride, bbox, strength);
         break;
     default:
         GST_DEBUG("Unsupported filter type");
@@ -59,3 +182,248 @@ gboolean apply_filter(GstVideoMeta *meta, guint8 *data, GstDetection *detection,
 
     return TRUE;
 }
+
+static void run_job(FilterJob *job, gpointer userData)
+{
+    job->ret = filter_region(*job->frame, job->data, job->stride, &job->bbox, job->filterType, job->strength);
+
+    g_mutex_lock(&job->workers->mtxPending);
+    job->workers->pending--;
+    if (job->workers->pending == 0)
+        g_cond_signal(&job->workers->condPending);
+    g_mutex_unlock(&job->workers->mtxPending);
+}
+
+// All instances share a single pool sized to the number of processors
+static GMutex mtxSharedPool;
+static GThreadPool *sharedPool = NULL;
+static guint sharedPoolUsers = 0;
+
+static GThreadPool *acquire_shared_pool()
+{
+    g_mutex_lock(&mtxSharedPool);
+    if (!sharedPool)
+        sharedPool = g_thread_pool_new((GFunc)run_job, NULL, g_get_num_processors(), TRUE, NULL);
+    sharedPoolUsers++;
+    g_mutex_unlock(&mtxSharedPool);
+
+    return sharedPool;
+}
+
+static void release_shared_pool()
+{
+    g_mutex_lock(&mtxSharedPool);
+    if (--sharedPoolUsers == 0)
+    {
+        g_thread_pool_free(sharedPool, FALSE, TRUE);
+        sharedPool = NULL;
+    }
+    g_mutex_unlock(&mtxSharedPool);
+}
+
+ObstructWorkers *obstruct_workers_new(guint threadCount)
+{
+    ObstructWorkers *workers = g_new0(ObstructWorkers, 1);
+    g_mutex_init(&workers->mtxWorkers);
+    g_mutex_init(&workers->mtxPending);
+    g_cond_init(&workers->condPending);
+    obstruct_workers_set_thread_count(workers, threadCount);
+
+    return workers;
+}
+
+void obstruct_workers_set_thread_count(ObstructWorkers *workers, guint threadCount)
+{
+    // More jobs than processors only add contention on the shared pool
+    guint processors = g_get_num_processors();
+    if (threadCount == 0 || threadCount > processors)
+        threadCount = processors;
+
+    g_mutex_lock(&workers->mtxWorkers);
+    workers->threadCount = threadCount;
+
+    // A single thread runs on the streaming thread directly
+    if (threadCount == 1 && workers->pool)
+    {
+        release_shared_pool();
+        workers->pool = NULL;
+    }
+    else if (threadCount > 1 && !workers->pool)
+        workers->pool = acquire_shared_pool();
+    g_mutex_unlock(&workers->mtxWorkers);
+}
+
+void obstruct_workers_free(ObstructWorkers *workers)
+{
+    if (workers->pool)
+        release_shared_pool();
+    g_mutex_clear(&workers->mtxWorkers);
+    g_mutex_clear(&workers->mtxPending);
+    g_cond_clear(&workers->condPending);
+    g_free(workers);
+}
+
+// Splits large regions into horizontal bands so that a single region can use several workers.
+// Blurring reads across band borders and is therefore only distributed per region.
+static void add_jobs(std::vector<FilterJob> &jobs, FilterJob &job, guint threadCount)
+{
+    const gint64 pixels = (gint64)job.bbox.width * job.bbox.height;
+    if (threadCount < 2 || job.filterType == FILTER_TYPE_BLUR || pixels < BAND_MIN_PIXELS)
+    {
+        jobs.push_back(job);
+        return;
+    }
+
+    // Bands of a pixelated region have to start at a block border to keep the blocks intact
+    const gint alignment = job.filterType == FILTER_TYPE_PIXELATE ? MAX((gint)job.strength, 1) : 1;
+    gint bandHeight = (job.bbox.height + threadCount - 1) / threadCount;
+    bandHeight = (bandHeight + alignment - 1) / alignment * alignment;
+
+    for (gint y = 0; y < job.bbox.height; y += bandHeight)
+    {
+        FilterJob band = job;
+        band.bbox.y = job.bbox.y + y;
+        band.bbox.height = MIN(bandHeight, job.bbox.height - y);
+        jobs.push_back(band);
+    }
+}
+
+gboolean apply_filter(GstVideoMeta *meta, guint8 *data, GArray *regions, FilterType filterType, guint strength, ObstructCache *cache, GstChangeMeta *changeMeta, GstClockTime pts, ObstructWorkers *workers)
+{
+    Mat frame;
+    GArray *clippedRegions, *disjointRegions;
+    std::map<CacheKey, CacheEntry> cacheEntries;
+    std::vector<BoundingBox> filteredRegions;
+    std::vector<FilterJob> jobs;
+    guint threadCount = 1;
+    gboolean ret = TRUE;
+
+    // Create Mat from the raw data
+    switch (meta->format)
+    {
+    case GST_VIDEO_FORMAT_BGRA:
+        frame = Mat(meta->height, meta->width, CV_8UC4, data, meta->stride[0]);
+        break;
+    default:
+        GST_DEBUG("Unsupported video format");
+        return FALSE;
+    }
+
+    // Keep the pool while the frame is distributed on it
+    if (workers)
+    {
+        g_mutex_lock(&workers->mtxWorkers);
+        threadCount = workers->pool ? workers->threadCount : 1;
+    }
+
+    // Clip all regions to the frame
+    BoundingBox frameBox = {
+        .x = 0,
+        .y = 0,
+        .width = (gint)meta->width,
+        .height = (gint)meta->height,
+    };
+    clippedRegions = g_array_sized_new(FALSE, FALSE, sizeof(BoundingBox), regions->len);
+    for (guint i = 0; i < regions->len; i++)
+    {
+        BoundingBox region = gst_bounding_box_intersect(&g_array_index(regions, BoundingBox, i), &frameBox);
+        if (region.width <= 0 || region.height <= 0)
+        {
+            GST_DEBUG("Invalid region");
+            continue; // Don't abort stream
+        }
+
+        g_array_append_val(clippedRegions, region);
+    }
+
+    // Merge overlapping regions so that every pixel is only processed once
+    disjointRegions = gst_bounding_box_make_disjoint(clippedRegions);
+    g_array_free(clippedRegions, TRUE);
+
+    // Only the expensive filters are worth caching. Every output region only depends on its own input pixels.
+    gboolean useCache = cache && (filterType == FILTER_TYPE_BLUR || filterType == FILTER_TYPE_PIXELATE);
+    if (cache && (!useCache || cache->filterType != filterType || cache->strength != strength || cache->width != meta->width || cache->height != meta->height))
+    {
+        obstruct_cache_clear(cache);
+        cache->filterType = filterType;
+        cache->strength = strength;
+        cache->width = meta->width;
+        cache->height = meta->height;
+    }
+
+    // Collect the regions that have to be filtered
+    for (guint i = 0; i < disjointRegions->len; i++)
+    {
+        BoundingBox *bbox = &g_array_index(disjointRegions, BoundingBox, i);
+        CacheKey key = std::make_tuple(bbox->x, bbox->y, bbox->width, bbox->height);
+
+        // Restore unchanged regions from the last frame instead of filtering them again. Changes below the change
+        // detector threshold are not reported, so entries are refreshed after a while to not let them accumulate.
+        if (useCache && region_unchanged(bbox, changeMeta, cache))
+        {
+            auto entry = cache->entries.find(key);
+            if (entry != cache->entries.end() && entry->second.age < CACHE_MAX_AGE)
+            {
+                copy_region(data, meta->stride[0], bbox, entry->second.pixels.data(), TRUE);
+                cacheEntries[key] = std::move(entry->second);
+                cacheEntries[key].age++;
+                continue;
+            }
+        }
+
+        FilterJob job = {workers, &frame, data, meta->stride[0], *bbox, filterType, strength, TRUE};
+        add_jobs(jobs, job, threadCount);
+        filteredRegions.push_back(*bbox);
+    }
+
+    // Apply filter effect in place, either on the worker pool or directly
+    if (threadCount > 1 && jobs.size() > 1)
+    {
+        g_mutex_lock(&workers->mtxPending);
+        workers->pending = jobs.size();
+        g_mutex_unlock(&workers->mtxPending);
+
+        for (FilterJob &job : jobs)
+            g_thread_pool_push(workers->pool, &job, NULL);
+
+        g_mutex_lock(&workers->mtxPending);
+        while (workers->pending > 0)
+            g_cond_wait(&workers->condPending, &workers->mtxPending);
+        g_mutex_unlock(&workers->mtxPending);
+    }
+    else
+    {
+        for (FilterJob &job : jobs)
+            job.ret = filter_region(frame, data, job.stride, &job.bbox, job.filterType, job.strength);
+    }
+
+    if (workers)
+        g_mutex_unlock(&workers->mtxWorkers);
+
+    for (FilterJob &job : jobs)
+        ret = ret && job.ret;
+
+    if (useCache && ret)
+    {
+        for (BoundingBox &bbox : filteredRegions)
+        {
+            CacheEntry &entry = cacheEntries[std::make_tuple(bbox.x, bbox.y, bbox.width, bbox.height)];
+            entry.pixels.resize((gsize)bbox.width * bbox.height * PRIVACY_FILTER_CHANNELS);
+            entry.age = 0;
+            copy_region(data, meta->stride[0], &bbox, entry.pixels.data(), FALSE);
+        }
+    }
+
+    // Keep only the regions of this frame
+    if (useCache && ret)
+    {
+        cache->entries.swap(cacheEntries);
+        cache->pts = pts;
+    }
+    else if (useCache)
+        obstruct_cache_clear(cache);
+
+    g_array_free(disjointRegions, TRUE);
+
+    return ret;
+}
@@ -8,16 +8,32 @@ extern "C"
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include <detectionmeta.h>
+#include <changemeta.h>
 
 enum _FilterType
 {
     FILTER_TYPE_BLACK,
     FILTER_TYPE_WHITE,
     FILTER_TYPE_BLUR,
+    FILTER_TYPE_PIXELATE,
 };
 typedef enum _FilterType FilterType;
 
-gboolean apply_filter(GstVideoMeta *meta, guint8 *data, GstDetection *detection, FilterType filterType, gfloat margin);
+// Holds the obstructed output of the last frame per region
+typedef struct _ObstructCache ObstructCache;
+
+ObstructCache *obstruct_cache_new();
+void obstruct_cache_clear(ObstructCache *cache);
+void obstruct_cache_free(ObstructCache *cache);
+
+// Persistent thread pool the regions of a frame are distributed on
+typedef struct _ObstructWorkers ObstructWorkers;
+
+ObstructWorkers *obstruct_workers_new(guint threadCount);
+void obstruct_workers_set_thread_count(ObstructWorkers *workers, guint threadCount);
+void obstruct_workers_free(ObstructWorkers *workers);
+
+gboolean apply_filter(GstVideoMeta *meta, guint8 *data, GArray *regions, FilterType filterType, guint strength, ObstructCache *cache, GstChangeMeta *changeMeta, GstClockTime pts, ObstructWorkers *workers);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,130 @@
+#include "privacyfilter.h"
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#define FIXED_POINT_SHIFT 22 // Division by the window size is done via a fixed point reciprocal
+#define FIXED_POINT_ROUNDING (1 << (FIXED_POINT_SHIFT - 1))
+
+// Computes the running sum box filter over a single row of BGRA pixels.
+// The input line has to be padded by "radius" replicated pixels on the left and "radius + 1" on the right.
+static void box_blur_line(const guint8 *padded, guint8 *out, gint length, gint radius, guint32 reciprocal)
+{
+    const gint window = (2 * radius + 1) * PRIVACY_FILTER_CHANNELS;
+    guint32 sum[PRIVACY_FILTER_CHANNELS] = {0};
+
+    for (gint i = 0; i < window; i += PRIVACY_FILTER_CHANNELS)
+        for (gint c = 0; c < PRIVACY_FILTER_CHANNELS; c++)
+            sum[c] += padded[i + c];
+
+    for (gint i = 0; i < length * PRIVACY_FILTER_CHANNELS; i += PRIVACY_FILTER_CHANNELS)
+    {
+        for (gint c = 0; c < PRIVACY_FILTER_CHANNELS; c++)
+        {
+            out[i + c] = (guint8)((sum[c] * reciprocal + FIXED_POINT_ROUNDING) >> FIXED_POINT_SHIFT);
+            sum[c] += padded[i + window + c] - padded[i + c]; // Slide window by one pixel
+        }
+    }
+}
+
+void privacy_filter_box_blur(guint8 *data, gsize stride, BoundingBox *region, guint radius, guint passes)
+{
+    if (region->width <= 0 || region->height <= 0 || radius == 0)
+        return;
+
+    const gint width = region->width, height = region->height;
+    const gsize rowSize = (gsize)width * PRIVACY_FILTER_CHANNELS;
+    const guint32 reciprocal = (1 << FIXED_POINT_SHIFT) / (2 * radius + 1);
+    guint8 *origin = data + region->y * stride + (gsize)region->x * PRIVACY_FILTER_CHANNELS;
+
+    std::vector<guint8> line(rowSize + (2 * radius + 1) * PRIVACY_FILTER_CHANNELS);
+    std::vector<guint32> sums(rowSize);
+    std::vector<guint8> copy(rowSize * height);
+
+    for (guint pass = 0; pass < passes; pass++)
+    {
+        // Horizontal pass, row by row through an edge padded line buffer
+        for (gint y = 0; y < height; y++)
+        {
+            guint8 *row = origin + y * stride;
+            guint8 *padded = line.data();
+            for (guint k = 0; k < radius; k++, padded += PRIVACY_FILTER_CHANNELS)
+                memcpy(padded, row, PRIVACY_FILTER_CHANNELS);
+            memcpy(padded, row, rowSize);
+            padded += rowSize;
+            for (guint k = 0; k <= radius; k++, padded += PRIVACY_FILTER_CHANNELS)
+                memcpy(padded, row + rowSize - PRIVACY_FILTER_CHANNELS, PRIVACY_FILTER_CHANNELS);
+
+            box_blur_line(line.data(), row, width, radius, reciprocal);
+        }
+
+        // Vertical pass, using per column accumulators so that memory is traversed row by row
+        for (gint y = 0; y < height; y++)
+            memcpy(copy.data() + y * rowSize, origin + y * stride, rowSize);
+
+        const guint8 *first = copy.data();
+        for (gsize i = 0; i < rowSize; i++)
+            sums[i] = (radius + 1) * first[i];
+        for (gint k = 1; k <= (gint)radius; k++)
+        {
+            const guint8 *src = copy.data() + MIN(k, height - 1) * rowSize;
+            for (gsize i = 0; i < rowSize; i++)
+                sums[i] += src[i];
+        }
+
+        for (gint y = 0; y < height; y++)
+        {
+            guint8 *row = origin + y * stride;
+            for (gsize i = 0; i < rowSize; i++)
+                row[i] = (guint8)((sums[i] * reciprocal + FIXED_POINT_ROUNDING) >> FIXED_POINT_SHIFT);
+
+            const guint8 *add = copy.data() + MIN(y + (gint)radius + 1, height - 1) * rowSize;
+            const guint8 *sub = copy.data() + MAX(y - (gint)radius, 0) * rowSize;
+            for (gsize i = 0; i < rowSize; i++)
+                sums[i] += add[i] - sub[i];
+        }
+    }
+}
+
+void privacy_filter_pixelate(guint8 *data, gsize stride, BoundingBox *region, guint blockSize)
+{
+    if (region->width <= 0 || region->height <= 0 || blockSize == 0)
+        return;
+
+    guint8 *origin = data + region->y * stride + (gsize)region->x * PRIVACY_FILTER_CHANNELS;
+
+    for (gint by = 0; by < region->height; by += blockSize)
+    {
+        const gint blockHeight = MIN((gint)blockSize, region->height - by);
+
+        for (gint bx = 0; bx < region->width; bx += blockSize)
+        {
+            const gint blockWidth = MIN((gint)blockSize, region->width - bx);
+            const gsize blockRowSize = (gsize)blockWidth * PRIVACY_FILTER_CHANNELS;
+            guint8 *block = origin + by * stride + (gsize)bx * PRIVACY_FILTER_CHANNELS;
+
+            // Average the block
+            guint32 sum[PRIVACY_FILTER_CHANNELS] = {0};
+            for (gint y = 0; y < blockHeight; y++)
+            {
+                const guint8 *row = block + y * stride;
+                for (gsize i = 0; i < blockRowSize; i += PRIVACY_FILTER_CHANNELS)
+                    for (gint c = 0; c < PRIVACY_FILTER_CHANNELS; c++)
+                        sum[c] += row[i + c];
+            }
+
+            guint8 color[PRIVACY_FILTER_CHANNELS];
+            const guint32 count = blockWidth * blockHeight;
+            for (gint c = 0; c < PRIVACY_FILTER_CHANNELS; c++)
+                color[c] = (guint8)(sum[c] / count);
+
+            // Fill the block with its average
+            for (gint y = 0; y < blockHeight; y++)
+            {
+                guint8 *row = block + y * stride;
+                for (gsize i = 0; i < blockRowSize; i += PRIVACY_FILTER_CHANNELS)
+                    memcpy(row + i, color, PRIVACY_FILTER_CHANNELS);
+            }
+        }
+    }
+}
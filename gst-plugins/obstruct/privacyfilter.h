@@ -0,0 +1,22 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <glib.h>
+#include <detectionmeta.h>
+
+#define PRIVACY_FILTER_CHANNELS 4 // BGRA
+#define PRIVACY_FILTER_GAUSSIAN_PASSES 3 // Three box passes closely approximate a gaussian
+
+// Blurs the region in place using a running sum box filter. Cost per pixel is independent of the radius.
+void privacy_filter_box_blur(guint8 *data, gsize stride, BoundingBox *region, guint radius, guint passes);
+
+// Replaces the region in place by blocks of their average color
+void privacy_filter_pixelate(guint8 *data, gsize stride, BoundingBox *region, guint blockSize);
+
+#ifdef __cplusplus
+}
+#endif
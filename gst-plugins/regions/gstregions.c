@@ -32,6 +32,7 @@ enum
   PROP_ACTIVE,
   PROP_REGIONS,
   PROP_LABELS,
+  PROP_STATS,
 };
 
 GstStaticPadTemplate regions_src_template = GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
@@ -127,6 +128,9 @@ static void gst_regions_get_property(GObject *object, guint prop_id, GValue *val
         }
     }
     break;
+  case PROP_STATS:
+    g_value_take_boxed(value, gst_processing_stats_get_structure(filter->stats));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     break;
@@ -152,6 +156,7 @@ static GstFlowReturn gst_regions_transform_buffer(GstBaseTransform *base, GstBuf
   GstDetectionMeta *detectionMeta;
   GstVideoMeta *videoMeta;
   GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime begin = gst_processing_stats_begin();
 
   GST_DEBUG_OBJECT(filter, "Received buffer");
 
@@ -202,6 +207,7 @@ static GstFlowReturn gst_regions_transform_buffer(GstBaseTransform *base, GstBuf
   }
 
 out:
+  gst_processing_stats_end(filter->stats, begin);
   return ret;
 }
 
@@ -215,6 +221,8 @@ static void gst_regions_init(GstRegions *filter)
 
   filter->labels = g_ptr_array_new_with_free_func(g_free);
   g_ptr_array_add(filter->labels, g_strdup("regions"));
+
+  filter->stats = gst_processing_stats_new(GST_ELEMENT(filter));
 }
 
 // Object destructor -> called if an object gets destroyed
@@ -225,6 +233,7 @@ static void gst_regions_finalize(GObject *object)
   g_array_free(filter->regions, TRUE);
   g_free((void *)filter->prefix);
   g_ptr_array_free(filter->labels, TRUE);
+  gst_processing_stats_free(filter->stats);
 
   G_OBJECT_CLASS(gst_regions_parent_class)->finalize(object);
 }
@@ -275,6 +284,7 @@ static void gst_regions_class_init(GstRegionsClass *klass)
                                                                            NULL,
                                                                            G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property(gobject_class, PROP_STATS, gst_processing_stats_param_spec());
 
   // Set plugin metadata
   gst_element_class_set_static_metadata(gstelement_class,
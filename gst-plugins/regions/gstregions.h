@@ -2,6 +2,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <processingstats.h>
 
 G_BEGIN_DECLS
 
@@ -24,6 +25,8 @@ struct _GstRegions
   const char *prefix;
   gboolean active;
   GPtrArray *labels;
+
+  GstProcessingStats *stats;
 };
 
 struct _GstRegionsClass
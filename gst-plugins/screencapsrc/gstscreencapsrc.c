@@ -32,8 +32,17 @@ enum
   PROP_SOURCE_ID,
   PROP_SOURCE_TYPE,
   PROP_REPORT_LOCATIONS,
+  PROP_ADAPTIVE_RATE,
+  PROP_IDLE_FPS,
+  PROP_CAPTURE_REGION,
+  PROP_FOLLOW_WINDOW,
+  PROP_STATS,
 };
 
+#define DEFAULT_IDLE_FPS 1
+#define STATIC_FRAMES_BEFORE_IDLE 5 // Unchanged captures before the frame rate is lowered
+#define SIGNATURE_SAMPLE_STEP 8     // Every n-th pixel of every row is compared to detect changes, shifted by one per row
+
 static GstStaticPadTemplate video_src_template =
     GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS,
                             GST_STATIC_CAPS("video/x-raw, "
@@ -45,6 +54,54 @@ static GstStaticPadTemplate video_src_template =
 #define gst_screen_cap_src_parent_class parent_class
 G_DEFINE_TYPE(GstScreenCapSrc, gst_screen_cap_src, GST_TYPE_PUSH_SRC);
 
+// Parse a region in the form "x:y:width:height", anything else captures the whole source
+static void gst_screen_cap_src_set_capture_region(GstScreenCapSrc *src, const gchar *region)
+{
+  gint x = 0, y = 0, width = 0, height = 0;
+
+  if (region && *region)
+  {
+    gchar **coordStrings = g_strsplit(region, ":", 4);
+    if (g_strv_length(coordStrings) == 4)
+    {
+      x = atoi(coordStrings[0]);
+      y = atoi(coordStrings[1]);
+      width = atoi(coordStrings[2]);
+      height = atoi(coordStrings[3]);
+    }
+    g_strfreev(coordStrings);
+
+    if (width <= 0 || height <= 0)
+    {
+      GST_WARNING_OBJECT(src, "Invalid capture region '%s', capturing the whole source", region);
+      width = height = 0;
+    }
+  }
+
+  GST_OBJECT_LOCK(src);
+  g_free(src->captureRegion);
+  src->captureRegion = g_strdup(region);
+  src->regionX = x;
+  src->regionY = y;
+  src->regionWidth = width;
+  src->regionHeight = height;
+  GST_OBJECT_UNLOCK(src);
+}
+
+// Get the part of the source to capture. Returns FALSE if the whole source is captured.
+gboolean gst_screen_cap_src_get_region(GstScreenCapSrc *src, gint *x, gint *y, gint *width, gint *height, guint64 *followWindowId)
+{
+  GST_OBJECT_LOCK(src);
+  *x = src->regionX;
+  *y = src->regionY;
+  *width = src->regionWidth;
+  *height = src->regionHeight;
+  *followWindowId = src->sourceType == SOURCE_TYPE_DISPLAY ? src->followWindowId : 0;
+  GST_OBJECT_UNLOCK(src);
+
+  return *width > 0 || *followWindowId != 0;
+}
+
 // Property setter
 static void gst_screen_cap_src_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
 {
@@ -61,6 +118,20 @@ static void gst_screen_cap_src_set_property(GObject *object, guint prop_id, cons
   case PROP_REPORT_LOCATIONS:
     src->reportWindowLocations = g_value_get_boolean(value);
     break;
+  case PROP_ADAPTIVE_RATE:
+    src->adaptiveRate = g_value_get_boolean(value);
+    break;
+  case PROP_IDLE_FPS:
+    src->idleFps = g_value_get_uint(value);
+    break;
+  case PROP_CAPTURE_REGION:
+    gst_screen_cap_src_set_capture_region(src, g_value_get_string(value));
+    break;
+  case PROP_FOLLOW_WINDOW:
+    GST_OBJECT_LOCK(src);
+    src->followWindowId = g_value_get_uint64(value);
+    GST_OBJECT_UNLOCK(src);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     break;
@@ -83,6 +154,25 @@ static void gst_screen_cap_src_get_property(GObject *object, guint prop_id, GVal
   case PROP_REPORT_LOCATIONS:
     g_value_set_boolean(value, src->reportWindowLocations);
     break;
+  case PROP_ADAPTIVE_RATE:
+    g_value_set_boolean(value, src->adaptiveRate);
+    break;
+  case PROP_IDLE_FPS:
+    g_value_set_uint(value, src->idleFps);
+    break;
+  case PROP_CAPTURE_REGION:
+    GST_OBJECT_LOCK(src);
+    g_value_set_string(value, src->captureRegion);
+    GST_OBJECT_UNLOCK(src);
+    break;
+  case PROP_FOLLOW_WINDOW:
+    GST_OBJECT_LOCK(src);
+    g_value_set_uint64(value, src->followWindowId);
+    GST_OBJECT_UNLOCK(src);
+    break;
+  case PROP_STATS:
+    g_value_take_boxed(value, gst_processing_stats_get_structure(src->stats));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     break;
@@ -96,6 +186,14 @@ static gboolean gst_screen_cap_src_start(GstBaseSrc *parent)
 
   // Init capture
   gst_screen_cap_util_initialize(src->captureUtil, src);
+  gst_processing_stats_reset(src->stats);
+
+  // Start at full frame rate
+  src->lastFrameTime = 0;
+  src->activityInterval = 0;
+  src->staticFrames = 0;
+  src->lastSignature = 0;
+  gst_qos_tracker_reset(src->qos);
 
   // Get dimensions for capture
   gint width, height;
@@ -185,6 +283,12 @@ static gboolean gst_screen_cap_src_event(GstBaseSrc *parent, GstEvent *event)
 
   switch (GST_EVENT_TYPE(event))
   {
+  case GST_EVENT_QOS:
+  {
+    // Remember how far downstream is behind, the capture interval follows it
+    GST_LOG_OBJECT(src, "Received QoS event %" GST_PTR_FORMAT, event);
+    gst_qos_tracker_update(src->qos, event);
+  }; // No break to handle event in default way
   default:
     ret = GST_BASE_SRC_CLASS(parent_class)->event(parent, event);
     break;
@@ -355,11 +459,82 @@ out:
   return ret;
 }
 
+// Cheap fingerprint of a frame, only used to tell whether the screen changed
+static guint32 gst_screen_cap_src_get_signature(GstScreenCapSrc *src, GstBuffer *buffer)
+{
+  GstMapInfo map;
+  guint32 hash = 2166136261u; // FNV-1a
+
+  if (!gst_buffer_map(buffer, &map, GST_MAP_READ))
+    return 0;
+
+  gint width = GST_VIDEO_INFO_WIDTH(&src->info), height = GST_VIDEO_INFO_HEIGHT(&src->info);
+  gsize stride = GST_VIDEO_INFO_PLANE_STRIDE(&src->info, 0);
+  // Shifting the samples per row covers every column within a few rows, so that any change spanning a few pixels in
+  // either direction (a typed character, a blinking cursor) alters the signature
+  for (gint y = 0; y < height && y * stride < map.size; y++)
+  {
+    const guint32 *row = (const guint32 *)(map.data + y * stride);
+    for (gint x = y % SIGNATURE_SAMPLE_STEP; x < width && y * stride + (x + 1) * BYTES_PER_PIXEL <= map.size; x += SIGNATURE_SAMPLE_STEP)
+      hash = (hash ^ row[x]) * 16777619u;
+  }
+
+  gst_buffer_unmap(buffer, &map);
+
+  return hash;
+}
+
+static GstClockTime gst_screen_cap_src_get_min_interval(GstScreenCapSrc *src)
+{
+  return src->info.fps_n > 0 ? gst_util_uint64_scale(GST_SECOND, src->info.fps_d, src->info.fps_n) : 0;
+}
+
+// Time between two captures: the negotiated frame rate while the screen changes, lowered towards
+// the idle frame rate while it is static and while downstream is not able to keep up
+static GstClockTime gst_screen_cap_src_get_interval(GstScreenCapSrc *src)
+{
+  GstClockTime minInterval = gst_screen_cap_src_get_min_interval(src);
+  if (!src->adaptiveRate)
+    return minInterval;
+
+  GstClockTime idleInterval = MAX(GST_SECOND / src->idleFps, minInterval);
+  GstClockTime interval = src->activityInterval;
+
+  gdouble proportion = gst_qos_tracker_get_proportion(src->qos);
+  if (proportion > 1.0)
+    interval = MAX(interval, (GstClockTime)(minInterval * proportion));
+
+  return CLAMP(interval, minInterval, idleInterval);
+}
+
+// Adapt the capture interval to the change between the last two frames
+static void gst_screen_cap_src_update_activity(GstScreenCapSrc *src, GstBuffer *buffer)
+{
+  guint32 signature = gst_screen_cap_src_get_signature(src, buffer);
+
+  if (signature != src->lastSignature)
+  {
+    // Content changes, capture at full rate again
+    src->staticFrames = 0;
+    src->activityInterval = 0;
+  }
+  else if (++src->staticFrames >= STATIC_FRAMES_BEFORE_IDLE)
+  {
+    // Slowly approach the idle rate, so short pauses keep a responsive frame rate
+    GstClockTime interval = MAX(src->activityInterval, gst_screen_cap_src_get_min_interval(src)) * 2;
+    src->activityInterval = MIN(interval, GST_SECOND / src->idleFps);
+  }
+
+  src->lastSignature = signature;
+  GST_LOG_OBJECT(src, "%u static frames, activity interval %" GST_TIME_FORMAT, src->staticFrames, GST_TIME_ARGS(src->activityInterval));
+}
+
 // Main capturing event -> creates a new buffer
 static GstFlowReturn gst_screen_cap_src_create(GstPushSrc *parent, GstBuffer **buffer)
 {
   GstScreenCapSrc *src = GST_SCREEN_CAP_SRC(parent);
-  GstClockTime baseTime, nextFrameTime;
+  GstClockTime nextFrameTime, begin;
+  GstFlowReturn flowRet;
 
   if (!src->lastFrameTime)
   {
@@ -367,21 +542,43 @@ static GstFlowReturn gst_screen_cap_src_create(GstPushSrc *parent, GstBuffer **b
     goto create_buffer;
   }
 
-  // Determine next frame time from last frame time
-  baseTime = GST_ELEMENT_CAST(src)->base_time;
-  nextFrameTime = src->lastFrameTime + src->info.fps_d / src->info.fps_n * GST_SECOND;
+  gboolean late;
+  do
+  {
+    // Determine next frame time from last frame time
+    nextFrameTime = src->lastFrameTime + gst_screen_cap_src_get_interval(src);
+
+    // Block until next frame time arrives to prevent unnecessary captures
+    GstClockID clockId = gst_clock_new_single_shot_id(GST_ELEMENT_CLOCK(src), nextFrameTime);
+    GST_TRACE_OBJECT(src, "Waiting for next frame time %" G_GUINT64_FORMAT, nextFrameTime);
+    GstClockReturn ret = gst_clock_id_wait(clockId, NULL);
+    GST_TRACE_OBJECT(src, "Done waiting for frame time %" G_GUINT64_FORMAT, nextFrameTime);
+    gst_clock_id_unref(clockId);
+
+    src->lastFrameTime = nextFrameTime;
+
+    // Skip captures downstream reported to be too late for, they would be dropped after processing anyway
+    GstClockTime baseTime = GST_ELEMENT_CAST(src)->base_time;
+    late = ret != GST_CLOCK_UNSCHEDULED && nextFrameTime > baseTime && gst_qos_tracker_is_late(src->qos, nextFrameTime - baseTime);
+    if (late)
+    {
+      GST_DEBUG_OBJECT(src, "Skipping late capture at %" GST_TIME_FORMAT, GST_TIME_ARGS(nextFrameTime - baseTime));
+      gst_processing_stats_add_skipped(src->stats);
+    }
+  } while (late);
 
-  // Block until next frame time arrives to prevent unnecessary captures
-  GstClockID clockId = gst_clock_new_single_shot_id(GST_ELEMENT_CLOCK(src), nextFrameTime);
-  GST_TRACE_OBJECT(src, "Waiting for next frame time %" G_GUINT64_FORMAT, nextFrameTime);
-  GstClockReturn ret = gst_clock_id_wait(clockId, NULL);
-  GST_TRACE_OBJECT(src, "Done waiting for frame time %" G_GUINT64_FORMAT, nextFrameTime);
-  gst_clock_id_unref(clockId);
+create_buffer:
+  // Only measure the capture itself, not the wait for the frame time
+  begin = gst_processing_stats_begin();
+  flowRet = gst_screen_cap_util_create_buffer(src->captureUtil, src, buffer);
+  if (flowRet != GST_FLOW_OK)
+    gst_processing_stats_add_dropped(src->stats);
+  gst_processing_stats_end(src->stats, begin);
 
-  src->lastFrameTime = nextFrameTime;
+  if (flowRet == GST_FLOW_OK && src->adaptiveRate)
+    gst_screen_cap_src_update_activity(src, *buffer);
 
-create_buffer:
-  return gst_screen_cap_util_create_buffer(src->captureUtil, src, buffer);
+  return flowRet;
 }
 
 // Object constructor -> called for every instance
@@ -394,12 +591,20 @@ static void gst_screen_cap_src_init(GstScreenCapSrc *src)
   src->sourceId = 0;
   src->sourceType = SOURCE_TYPE_DISPLAY;
   src->reportWindowLocations = FALSE;
+  src->adaptiveRate = TRUE;
+  src->idleFps = DEFAULT_IDLE_FPS;
+  src->captureRegion = NULL;
+  src->regionX = src->regionY = src->regionWidth = src->regionHeight = 0;
+  src->followWindowId = 0;
 
   // Will be initialized in the start function
   src->initialized = FALSE;
 
   // Create capture util
   src->captureUtil = gst_screen_cap_util_new();
+
+  src->stats = gst_processing_stats_new(GST_ELEMENT(src));
+  src->qos = gst_qos_tracker_new();
 }
 
 // Object destructor -> called if an object gets destroyed
@@ -409,6 +614,9 @@ static void gst_screen_cap_src_finalize(GObject *object)
 
   // If necessary, members of the object can be freed here
   g_object_unref(src->captureUtil);
+  g_free(src->captureRegion);
+  gst_processing_stats_free(src->stats);
+  gst_qos_tracker_free(src->qos);
 
   G_OBJECT_CLASS(gst_screen_cap_src_parent_class)->finalize(object);
 }
@@ -446,6 +654,28 @@ static void gst_screen_cap_src_class_init(GstScreenCapSrcClass *klass)
                                                        "If true, metadata with all window locations at capture time is added",
                                                        FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property(gobject_class, PROP_ADAPTIVE_RATE,
+                                  g_param_spec_boolean("adaptive-rate", "Adaptive Rate",
+                                                       "If true, the frame rate is lowered while the screen is static or downstream is too slow",
+                                                       TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(gobject_class, PROP_IDLE_FPS,
+                                  g_param_spec_uint("idle-fps", "Idle FPS",
+                                                    "Frame rate the adaptive rate falls back to while the screen is static", 1,
+                                                    G_MAXUINT, DEFAULT_IDLE_FPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(gobject_class, PROP_CAPTURE_REGION,
+                                  g_param_spec_string("capture-region", "Capture Region",
+                                                      "Only capture this part of the source, given as x:y:width:height (X11 only)",
+                                                      NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(gobject_class, PROP_FOLLOW_WINDOW,
+                                  g_param_spec_uint64("follow-window", "Follow Window",
+                                                      "When capturing a display, only capture the area of the window with this ID (X11 only)", 0,
+                                                      G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(gobject_class, PROP_STATS, gst_processing_stats_param_spec());
+
   // Set plugin metadata
   gst_element_class_set_static_metadata(gstelement_class,
                                         "Mac screen capture source", "Source/Video",
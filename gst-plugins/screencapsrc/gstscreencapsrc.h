@@ -7,6 +7,8 @@ typedef struct _GstScreenCapSrcClass GstScreenCapSrcClass;
 #include <gst/gst.h>
 #include <gst/base/gstpushsrc.h>
 #include <gst/video/video.h>
+#include <processingstats.h>
+#include <qostracker.h>
 #include "screencaputil.h"
 
 G_BEGIN_DECLS
@@ -34,9 +36,23 @@ struct _GstScreenCapSrc
 
   GstVideoInfo info;
 
+  // Part of the source that is captured, protected by the object lock
+  gchar *captureRegion;
+  gint regionX, regionY, regionWidth, regionHeight; // Parsed capture region, a width of 0 captures the whole source
+  guint64 followWindowId;                            // Window whose area on the display is captured, 0 if unused
+
   GstClockTime lastFrameTime;
 
+  // Adaptive frame rate, the negotiated frame rate is the maximum
+  gboolean adaptiveRate;
+  guint idleFps;
+  GstClockTime activityInterval; // Interval derived from the screen activity, grows while the screen is static
+  guint staticFrames;            // Captures without change in a row
+  guint32 lastSignature;
+
   GstScreenCapUtil *captureUtil;
+  GstProcessingStats *stats;
+  GstQosTracker *qos;
 };
 
 struct _GstScreenCapSrcClass
@@ -44,4 +60,6 @@ struct _GstScreenCapSrcClass
   GstPushSrcClass parent_class;
 };
 
+gboolean gst_screen_cap_src_get_region(GstScreenCapSrc *src, gint *x, gint *y, gint *width, gint *height, guint64 *followWindowId);
+
 G_END_DECLS
@@ -22,11 +22,94 @@ struct _GstScreenCapUtilPrivate
 // ----------------------------------------- Private Helper --------------------------------------------
 // -----------------------------------------------------------------------------------------------------
 
-void get_frame(gulong windowId, Display *display, XImage **imageRef, gint *width, gint *height, gint *x, gint *y, size_t *stride, size_t *size)
+// Catches the errors of requests on windows that may be gone, Xlib's default handler would exit the application.
+// The handler is process wide, so only one trap can be active at a time.
+static GMutex mtxErrorTrap;
+static XErrorHandler previousErrorHandler;
+static unsigned char trappedError;
+
+static int trap_error(Display *display, XErrorEvent *event)
+{
+    if (trappedError == Success)
+        trappedError = event->error_code;
+
+    return 0;
+}
+
+static void error_trap_push(Display *display)
+{
+    g_mutex_lock(&mtxErrorTrap);
+
+    // Errors of earlier requests belong to the previous handler
+    XSync(display, False);
+    trappedError = Success;
+    previousErrorHandler = XSetErrorHandler(trap_error);
+}
+
+// Returns the first error since the trap was pushed, Success if there was none
+static unsigned char error_trap_pop(Display *display)
+{
+    XSync(display, False);
+    XSetErrorHandler(previousErrorHandler);
+    unsigned char error = trappedError;
+
+    g_mutex_unlock(&mtxErrorTrap);
+
+    return error;
+}
+
+// Rectangle of the source to capture, the whole source unless a capture region or window to follow is set
+static void get_capture_rect(GstScreenCapSrc *src, Display *display, gulong windowId, XWindowAttributes *windowAttributes, gint *x, gint *y, gint *width, gint *height)
+{
+    guint64 followWindowId;
+
+    *x = 0;
+    *y = 0;
+    *width = windowAttributes->width;
+    *height = windowAttributes->height;
+
+    gint regionX, regionY, regionWidth, regionHeight;
+    if (!gst_screen_cap_src_get_region(src, &regionX, &regionY, &regionWidth, &regionHeight, &followWindowId))
+        return;
+
+    if (followWindowId)
+    {
+        // Area of the window on the captured display, including everything covering it
+        XWindowAttributes followAttributes;
+        Window child;
+        error_trap_push(display);
+        gboolean found = XGetWindowAttributes(display, followWindowId, &followAttributes) &&
+                         XTranslateCoordinates(display, followWindowId, windowId, 0, 0, &regionX, &regionY, &child);
+        if (error_trap_pop(display) != Success || !found)
+        {
+            // The window has been closed, capture the whole source
+            GST_DEBUG_OBJECT(src, "Window %" G_GUINT64_FORMAT " to follow is gone", followWindowId);
+            return;
+        }
+
+        regionWidth = followAttributes.width;
+        regionHeight = followAttributes.height;
+    }
+
+    // Keep the rectangle within the source, with at least one pixel so the stream does not break
+    gint left = CLAMP(regionX, 0, windowAttributes->width - 1);
+    gint top = CLAMP(regionY, 0, windowAttributes->height - 1);
+    gint right = CLAMP(regionX + regionWidth, left + 1, windowAttributes->width);
+    gint bottom = CLAMP(regionY + regionHeight, top + 1, windowAttributes->height);
+
+    *x = left;
+    *y = top;
+    *width = right - left;
+    *height = bottom - top;
+}
+
+void get_frame(GstScreenCapSrc *src, Display *display, XImage **imageRef, gint *width, gint *height, gint *x, gint *y, size_t *stride, size_t *size)
 {
     gboolean ret;
 
+    gulong windowId = src->sourceId;
     XWindowAttributes windowAttributes;
+    gint captureX, captureY, captureWidth, captureHeight;
 
     *imageRef = NULL;
     guint counter = 0;
@@ -41,7 +124,9 @@ void get_frame(gulong windowId, Display *display, XImage **imageRef, gint *width
         if (!ret)
             return;
 
-        *imageRef = XGetImage(display, windowId, 0, 0, windowAttributes.width, windowAttributes.height, AllPlanes, ZPixmap);
+        // Only copy the requested part of the source from the X server
+        get_capture_rect(src, display, windowId, &windowAttributes, &captureX, &captureY, &captureWidth, &captureHeight);
+        *imageRef = XGetImage(display, windowId, captureX, captureY, captureWidth, captureHeight, AllPlanes, ZPixmap);
         counter++;
     }
 
@@ -49,22 +134,22 @@ void get_frame(gulong windowId, Display *display, XImage **imageRef, gint *width
         return;
 
     if (width)
-        *width = windowAttributes.width;
+        *width = captureWidth;
 
     if (height)
-        *height = windowAttributes.height;
+        *height = captureHeight;
 
     if (x)
-        *x = windowAttributes.x;
+        *x = windowAttributes.x + captureX;
 
     if (y)
-        *y = windowAttributes.y;
+        *y = windowAttributes.y + captureY;
 
-    size_t str = windowAttributes.width * BYTES_PER_PIXEL;
+    size_t str = captureWidth * BYTES_PER_PIXEL;
     if (stride)
         *stride = str;
 
-    size_t s = str * windowAttributes.height;
+    size_t s = str * captureHeight;
     if (size)
         *size = s;
 }
@@ -81,7 +166,7 @@ gboolean gst_screen_cap_util_get_dimensions(GstScreenCapUtil *self, GstScreenCap
     XImage *imageRef = NULL;
 
     // Get dimensions
-    get_frame(src->sourceId, self->priv->display, &imageRef, width, height, NULL, NULL, NULL, size);
+    get_frame(src, self->priv->display, &imageRef, width, height, NULL, NULL, NULL, size);
 
     XFree((void *)imageRef);
     return TRUE;
@@ -118,7 +203,7 @@ GstFlowReturn gst_screen_cap_util_create_buffer(GstScreenCapUtil *self, GstScree
     }
 
     // Decide on display vs. window capture and do the capture
-    get_frame(src->sourceId, self->priv->display, &imageRef, &width, &height, &x, &y, &stride, &size);
+    get_frame(src, self->priv->display, &imageRef, &width, &height, &x, &y, &stride, &size);
 
     // Unable to capture frame
     if (!imageRef)
@@ -34,6 +34,7 @@ enum
   PROP_ACTIVE,
   PROP_DISPLAY_ID,
   PROP_LABELS,
+  PROP_STATS,
 };
 
 GstStaticPadTemplate win_analyzer_src_template = GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
@@ -119,6 +120,9 @@ static void gst_win_analyzer_get_property(GObject *object, guint prop_id, GValue
     g_hash_table_destroy(labelSet);
   }
   break;
+  case PROP_STATS:
+    g_value_take_boxed(value, gst_processing_stats_get_structure(filter->stats));
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     break;
@@ -130,6 +134,8 @@ static gboolean gst_win_analyzer_start(GstBaseTransform *base)
 {
   GstWinAnalyzer *filter = GST_WIN_ANALYZER(base);
 
+  gst_processing_stats_reset(filter->stats);
+
   GstStructure *payload = gst_structure_new_from_string("report_window_locations, active=true");
   GstQuery *query = gst_query_new_custom(GST_QUERY_CUSTOM, payload);
 
@@ -162,6 +168,7 @@ static GstFlowReturn gst_win_analyzer_transform_buffer(GstBaseTransform *base, G
   GstDetectionMeta *detectionMeta;
   GstVideoMeta *videoMeta;
   GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime begin = gst_processing_stats_begin();
 
   GST_DEBUG_OBJECT(filter, "Received buffer");
 
@@ -268,6 +275,7 @@ static GstFlowReturn gst_win_analyzer_transform_buffer(GstBaseTransform *base, G
 out:
   g_array_free(winInfos, TRUE);
 
+  gst_processing_stats_end(filter->stats, begin);
   return ret;
 }
 
@@ -281,6 +289,8 @@ static void gst_win_analyzer_init(GstWinAnalyzer *filter)
 
   filter->labels = g_ptr_array_new_with_free_func(g_free);
   g_ptr_array_add(filter->labels, g_strdup("regions"));
+
+  filter->stats = gst_processing_stats_new(GST_ELEMENT(filter));
 }
 
 // Object destructor -> called if an object gets destroyed
@@ -290,6 +300,7 @@ static void gst_win_analyzer_finalize(GObject *object)
 
   g_free((void *)filter->prefix);
   g_ptr_array_free(filter->labels, TRUE);
+  gst_processing_stats_free(filter->stats);
 
   G_OBJECT_CLASS(gst_win_analyzer_parent_class)->finalize(object);
 }
@@ -336,6 +347,7 @@ static void gst_win_analyzer_class_init(GstWinAnalyzerClass *klass)
                                                                            NULL,
                                                                            G_PARAM_READABLE | G_PARAM_STATIC_STRINGS),
                                                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property(gobject_class, PROP_STATS, gst_processing_stats_param_spec());
 
   // Set plugin metadata
   gst_element_class_set_static_metadata(gstelement_class,
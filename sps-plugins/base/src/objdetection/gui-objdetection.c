@@ -35,6 +35,19 @@ static void update_labels(SpsPluginBaseGuiObjdetection *gui) {
     g_string_free(availableLabels, TRUE);
 }
 
+static gboolean idle_update_labels(SpsPluginBaseGuiObjdetection *gui)
+{
+    update_labels(gui);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void cb_labels_changed(GstElement *element, GParamSpec *pspec, SpsPluginBaseGuiObjdetection *gui)
+{
+    // Models are loaded in the background, the labels may change from any thread
+    g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, (GSourceFunc)idle_update_labels, g_object_ref(gui), g_object_unref);
+}
+
 static void fc_model_changed(GtkFileChooserButton *fc, SpsPluginBaseGuiObjdetection *gui)
 {
     const char *modelPath = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(fc));
@@ -126,6 +139,7 @@ static void sps_plugin_base_gui_objdetection_constructed(GObject *object)
 
     // Set labels
     update_labels(gui);
+    g_signal_connect_object(gui->element, "notify::labels", G_CALLBACK(cb_labels_changed), gui, 0);
 
     // Free memory
     g_free((void *)prefix);